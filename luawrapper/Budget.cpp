@@ -0,0 +1,106 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "luawrapper.h"
+
+namespace lua {
+
+namespace {
+const char budgetkey = 0;
+} /* anonymous namespace */
+
+Budget::Budget (std::uint64_t instructions, std::chrono::nanoseconds timeout_, Mode mode_, int granularity_)
+    : quota (instructions), timeout (timeout_), mode (mode_), granularity (granularity_ > 0 ? granularity_ : 1),
+      usage {0, std::chrono::nanoseconds::zero (), false}, totals (usage), thread (nullptr), yielding (false),
+      prevhook (nullptr), prevmask (0), prevcount (0), prevbudget (nullptr), chaining (false)
+{
+}
+
+void Budget::hook (lua_State *L, lua_Debug *ar)
+{
+    Budget *budget = static_cast<Budget*> (detail::GetRegistryPointer (L, &budgetkey));
+    if (budget == nullptr || budget->chaining) return;
+    if (budget->prevhook != nullptr && budget->prevhook != hook && (budget->prevmask & LUA_MASKCOUNT)) {
+        budget->chaining = true;
+        budget->prevhook (L, ar);
+        budget->chaining = false;
+    }
+    budget->usage.instructions += lua_gethookcount (L);
+    if ((budget->quota == 0 || budget->usage.instructions <= budget->quota)
+        && (budget->timeout == std::chrono::nanoseconds::zero () || clock::now () < budget->deadline)) {
+        return;
+    }
+    budget->usage.exceeded = true;
+    // a nested coroutine cannot yield the resumed thread, so it is aborted instead and
+    // its resumer stops at its next hook
+    if (budget->yielding && L == budget->thread) {
+        lua_yield (L, 0);
+        return;
+    }
+    // from now on every instruction raises the error again, so a script catching it with
+    // pcall is stopped right after the pcall returns
+    lua_sethook (L, hook, LUA_MASKCOUNT, 1);
+    luaL_error (L, "Lua error: execution budget exceeded.");
+}
+
+void Budget::begin (lua_State *L, bool yield)
+{
+    thread = L;
+    yielding = yield;
+    usage = Usage {0, std::chrono::nanoseconds::zero (), false};
+    prevhook = lua_gethook (L);
+    prevmask = lua_gethookmask (L);
+    prevcount = lua_gethookcount (L);
+    prevbudget = detail::GetRegistryPointer (L, &budgetkey);
+    chaining = false;
+    detail::SetRegistryPointer (L, &budgetkey, this);
+    lua_sethook (L, hook, LUA_MASKCOUNT, granularity);
+    start = clock::now ();
+    deadline = start + timeout;
+}
+
+int Budget::end (lua_State *L, int status)
+{
+    usage.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds> (clock::now () - start);
+    lua_sethook (L, prevhook, prevmask, prevcount);
+    detail::SetRegistryPointer (L, &budgetkey, prevbudget);
+    totals.instructions += usage.instructions;
+    totals.elapsed += usage.elapsed;
+    totals.exceeded = totals.exceeded || usage.exceeded;
+    thread = nullptr;
+    return status;
+}
+
+int Budget::pcall (lua_State *L, int nargs, int nresults, int errfunc)
+{
+    begin (L, false);
+    return end (L, lua_pcall (L, nargs, nresults, errfunc));
+}
+
+int Budget::resume (lua_State *T, int nargs)
+{
+    begin (T, mode == YIELD);
+    return end (T, lua_resume (T, nargs));
+}
+
+} /* namespace lua */
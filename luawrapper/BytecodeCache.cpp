@@ -0,0 +1,177 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#if !defined (_WIN32)
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include "luawrapper.h"
+
+namespace lua {
+
+namespace {
+
+std::uint64_t Hash (std::uint64_t hash, const char *data, std::size_t size)
+{
+    // FNV-1a
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char> (data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// name of the cache file, keyed by the lua version, the path used as chunk name and the source
+std::string CacheFile (const std::string &path, const detail::MappedFile &source, const std::string &cachedir)
+{
+    std::string version = LUA_VERSION;
+#if defined (LUAJIT_VERSION)
+    version += LUAJIT_VERSION;
+#endif
+    version += char ('0' + sizeof (void*));
+    version += char ('0' + sizeof (lua_Number));
+    std::uint64_t hash = 14695981039346656037ULL;
+    hash = Hash (hash, version.data (), version.size () + 1);
+    hash = Hash (hash, path.data (), path.size () + 1);
+    hash = Hash (hash, source.data (), source.size ());
+    char name[32];
+    std::snprintf (name, sizeof (name), "%016llx.luac", static_cast<unsigned long long> (hash));
+    return cachedir + "/" + name;
+}
+
+int WriteChunk (lua_State *L, const void *p, std::size_t size, void *ud)
+{
+    return std::fwrite (p, 1, size, static_cast<std::FILE*> (ud)) == size ? 0 : 1;
+}
+
+// compiles the source and stores the bytecode, leaving the compiled function or the error on the stack;
+// written tells whether the cache file was stored
+int Compile (lua_State *L, const std::string &path, const detail::MappedFile &source, const std::string &cachefile,
+             bool &written)
+{
+    written = false;
+    detail::BufferReader reader { source.data (), source.size () };
+    int status = lua_load (L, detail::BufferReader::read, &reader, ("@" + path).c_str ());
+    if (status != 0) return status;
+
+    // write to a temporary file first, so that concurrent loaders never see partial files
+    static std::atomic<unsigned int> counter (0);
+#if !defined (_WIN32)
+    long pid = getpid ();
+#else
+    long pid = _getpid ();
+#endif
+    std::string tmpfile = cachefile + "." + std::to_string (pid) + "." + std::to_string (counter++) + ".tmp";
+    std::FILE *file = std::fopen (tmpfile.c_str (), "wb");
+    if (file == nullptr) return 0;
+    bool ok = lua_dump (L, WriteChunk, file) == 0;
+    ok = std::fclose (file) == 0 && ok;
+#if defined (_WIN32)
+    std::remove (cachefile.c_str ());
+#endif
+    written = ok && std::rename (tmpfile.c_str (), cachefile.c_str ()) == 0;
+    if (!written) std::remove (tmpfile.c_str ());
+    return 0;
+}
+
+void FindScripts (const std::string &dir, std::vector<std::string> &paths)
+{
+#if !defined (_WIN32)
+    DIR *d = opendir (dir.c_str ());
+    if (d == nullptr) return;
+    while (dirent *entry = readdir (d)) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") continue;
+        std::string path = dir + "/" + name;
+        struct stat st;
+        if (stat (path.c_str (), &st) != 0) continue;
+        if (S_ISDIR (st.st_mode)) {
+            FindScripts (path, paths);
+        } else if (name.size () > 4 && name.compare (name.size () - 4, 4, ".lua") == 0) {
+            paths.push_back (path);
+        }
+    }
+    closedir (d);
+#else
+    throw std::runtime_error ("Listing script directories is not supported on this platform.");
+#endif
+}
+
+} /* anonymous namespace */
+
+int State::load_cached (const std::string &path, const std::string &cachedir)
+{
+    detail::MappedFile source (path);
+    if (!source.valid ()) {
+        lua_pushfstring (L, "cannot open %s", path.c_str ());
+        return LUA_ERRFILE;
+    }
+    std::string cachefile = CacheFile (path, source, cachedir);
+    detail::MappedFile cached (cachefile);
+    if (cached.valid () && cached.size () > 0) {
+        detail::BufferReader reader { cached.data (), cached.size () };
+        if (lua_load (L, detail::BufferReader::read, &reader, ("@" + path).c_str ()) == 0) return 0;
+        // fall back to the source if the cached chunk is corrupt
+        lua_pop (L, 1);
+    }
+    bool written;
+    return Compile (L, path, source, cachefile, written);
+}
+
+std::size_t State::precompile (const std::string &dir, const std::string &cachedir, unsigned int threads)
+{
+    std::vector<std::string> paths;
+    FindScripts (dir, paths);
+    if (threads == 0) threads = std::max (1u, std::thread::hardware_concurrency ());
+    std::atomic<std::size_t> next (0), compiled (0);
+    auto worker = [&] () {
+        lua_State *L = luaL_newstate ();
+        if (L == nullptr) return;
+        for (std::size_t i = next++; i < paths.size (); i = next++) {
+            detail::MappedFile source (paths[i]);
+            if (!source.valid ()) continue;
+            std::string cachefile = CacheFile (paths[i], source, cachedir);
+            if (detail::MappedFile (cachefile).valid ()) continue;
+            bool written;
+            Compile (L, paths[i], source, cachefile, written);
+            if (written) compiled++;
+            lua_settop (L, 0);
+        }
+        lua_close (L);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads && i < paths.size (); i++) pool.emplace_back (worker);
+    worker ();
+    for (auto &t : pool) t.join ();
+    return compiled;
+}
+
+} /* namespace lua */
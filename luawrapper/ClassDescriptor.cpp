@@ -0,0 +1,357 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <atomic>
+#include "luawrapper.h"
+
+namespace lua {
+namespace detail {
+
+ClassDescriptor::ClassDescriptor (const functionlist &functions, const size_t &typehash, const char *type)
+        : constructor (nullptr), destructorfn (nullptr), indexfn (nullptr), newindexfn (nullptr),
+          nslots (0), hasproperties (false), index (0), type (type)
+{
+    static std::atomic<std::size_t> next (1);
+    if (typehash != 0) index = next.fetch_add (1, std::memory_order_relaxed);
+    typehashs.push_back (typehash);
+    add (functions, true);
+    std::sort (typehashs.begin (), typehashs.end ());
+    typehashs.erase (std::unique (typehashs.begin (), typehashs.end ()), typehashs.end ());
+
+    // assign member table slots to methods
+    for (auto &entry : entries) {
+        if (entry.fn->type == function::PROPERTY) {
+            hasproperties = true;
+        } else {
+            entry.slot = ++nslots;
+        }
+    }
+
+    std::size_t tablesize = 1;
+    while (tablesize < entries.size ()) tablesize <<= 1;
+    while (!build (tablesize)) {
+        tablesize <<= 1;
+        if (tablesize > (std::size_t (1) << 24)) {
+            throw std::runtime_error ("Cannot generate member lookup table.");
+        }
+    }
+
+#if defined (LUAWRAPPER_PROFILE)
+    profileclass = Profiler::get_class (functions, type);
+    for (const auto &entry : entries) {
+        if (entry.slot) {
+            bindings.emplace_back (entry.fn, Profiler::binding (profileclass, *entry.fn, entry.name, entry.fn->func));
+        }
+    }
+    for (auto meta : metafunctions) {
+        bindings.emplace_back (meta, Profiler::binding (profileclass, *meta, meta->name, meta->func));
+    }
+    if (constructor != nullptr) {
+        bindings.emplace_back (constructor, Profiler::binding (profileclass, *constructor, "constructor", constructor->func));
+    }
+    std::sort (bindings.begin (), bindings.end ());
+#endif
+}
+
+void ClassDescriptor::add (const functionlist &functions, bool own)
+{
+    // entries present before this function list belong to derived or earlier base classes and are kept
+    std::size_t firstentry = entries.size ();
+    std::size_t firstmeta = metafunctions.size ();
+    bool hasindexfn = indexfn != nullptr, hasnewindexfn = newindexfn != nullptr;
+
+    for (const auto &fn : functions) {
+        switch (fn.type) {
+            case function::MEMBERFUNCTION:
+            case function::STATICFUNCTION:
+            case function::PROPERTY: {
+                std::size_t length = std::strlen (fn.name);
+                auto it = std::find_if (entries.begin (), entries.end (), [&] (const Entry &entry) {
+                    return entry.length == length && !std::memcmp (entry.name, fn.name, length);
+                });
+                if (it == entries.end ()) {
+                    entries.push_back ({ fn.name, length, &fn, 0 });
+                } else if (it - entries.begin () >= firstentry) {
+                    it->fn = &fn;
+                }
+                break;
+            }
+            case function::METAFUNCTION: {
+                if (!std::strcmp (fn.name, "__newindex")) {
+                    if (!hasnewindexfn) newindexfn = fn.func;
+                }
+                auto it = std::find_if (metafunctions.begin (), metafunctions.end (), [&] (const function *meta) {
+                    return !std::strcmp (meta->name, fn.name);
+                });
+                if (it == metafunctions.end ()) {
+                    metafunctions.push_back (&fn);
+                } else if (it - metafunctions.begin () >= firstmeta) {
+                    *it = &fn;
+                }
+                break;
+            }
+            case function::INDEXFUNCTION:
+                if (!hasindexfn) indexfn = fn.func;
+                break;
+            case function::CONSTRUCTOR:
+                if (own) constructor = &fn;
+                break;
+            case function::DESTRUCTOR:
+                if (own) destructorfn = fn.func;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // resolve base classes after the entries of the class itself
+    for (const auto &fn : functions) {
+        if (fn.type == function::BASECLASS) {
+            typehashs.push_back (fn.hashcode);
+            add (*fn.listptr, false);
+        }
+    }
+}
+
+bool ClassDescriptor::build (std::size_t tablesize)
+{
+    table.assign (tablesize, nullptr);
+    displacements.assign (entries.size () / 2 + 1, 0);
+
+    // distribute entries to buckets, each bucket gets a displacement that maps all its entries to free slots
+    std::vector<std::vector<const Entry*>> buckets (displacements.size ());
+    for (const auto &entry : entries) {
+        std::uint32_t f1 = static_cast<std::uint32_t> (hash (entry.name, entry.length));
+        buckets[f1 % buckets.size ()].push_back (&entry);
+    }
+    std::vector<std::size_t> order (buckets.size ());
+    for (std::size_t i = 0; i < order.size (); i++) order[i] = i;
+    std::stable_sort (order.begin (), order.end (), [&] (std::size_t a, std::size_t b) {
+        return buckets[a].size () > buckets[b].size ();
+    });
+
+    std::vector<std::size_t> slots;
+    for (auto b : order) {
+        if (buckets[b].empty ()) break;
+        bool placed = false;
+        for (std::uint32_t d = 0; d < 4 * tablesize && !placed; d++) {
+            slots.clear ();
+            for (auto entry : buckets[b]) {
+                std::uint64_t h = hash (entry->name, entry->length);
+                std::uint32_t f1 = static_cast<std::uint32_t> (h);
+                std::uint32_t f2 = static_cast<std::uint32_t> (h >> 32) | 1;
+                std::size_t slot = (f1 + d * f2) & (tablesize - 1);
+                if (table[slot] != nullptr || std::find (slots.begin (), slots.end (), slot) != slots.end ()) break;
+                slots.push_back (slot);
+            }
+            if (slots.size () == buckets[b].size ()) {
+                for (std::size_t i = 0; i < slots.size (); i++) {
+                    table[slots[i]] = buckets[b][i];
+                }
+                displacements[b] = d;
+                placed = true;
+            }
+        }
+        if (!placed) return false;
+    }
+    return true;
+}
+
+void ClassDescriptor::push_function (lua_State *L, const function *fn, int index) const noexcept
+{
+    if (index != 0) lua_pushvalue (L, index);
+#if defined (LUAWRAPPER_PROFILE)
+    // the wrapper keeps the upvalue of fn at index 1
+    if (index == 0) lua_pushnil (L);
+    auto it = std::lower_bound (bindings.begin (), bindings.end (), std::make_pair (fn, static_cast<Profiler::Binding*> (nullptr)));
+    lua_pushlightuserdata (L, it->second);
+    lua_pushcclosure (L, Profiler::Call, 2);
+#else
+    lua_pushcclosure (L, fn->func, index != 0 ? 1 : 0);
+#endif
+}
+
+void ClassDescriptor::push_metatable (lua_State *L, bool destructor) const noexcept
+{
+    // expects the object as light userdata on the stack
+    lua_createtable (L, 0, metafunctions.size () + 4);
+
+    for (auto meta : metafunctions) {
+        // push closure over the object
+        push_function (L, meta, -2);
+        // add to meta table
+        lua_setfield (L, -2, meta->name);
+    }
+
+    if (destructor && destructorfn != nullptr) {
+        lua_pushvalue (L, -2);
+        // the object counter of the class, looked up once here instead of on every collection
+        ObjectCounters::Counter *counter = nullptr;
+        ObjectCounters *counters = GetObjectCounters (L);
+        if (counters != nullptr) {
+            try {
+                counter = &counters->get (*this);
+            } catch (...) {
+            }
+        }
+        lua_pushlightuserdata (L, counter);
+        lua_pushcclosure (L, destructorfn, 2);
+        lua_setfield (L, -2, "__gc");
+    }
+
+    if (dispatching ()) {
+        // create member table
+        lua_createtable (L, nslots, 0);
+        for (const auto &entry : entries) {
+            if (entry.fn->type == function::MEMBERFUNCTION) {
+                push_function (L, entry.fn, -3);
+                lua_rawseti (L, -2, entry.slot);
+            } else if (entry.fn->type == function::STATICFUNCTION) {
+                push_function (L, entry.fn, 0);
+                lua_rawseti (L, -2, entry.slot);
+            }
+        }
+
+        // resolve members by the dispatcher
+        lua_pushvalue (L, -3);
+        lua_pushvalue (L, -2);
+        lua_pushlightuserdata (L, const_cast<ClassDescriptor*> (this));
+        lua_pushcclosure (L, Index, 3);
+        lua_setfield (L, -3, "__index");
+
+        lua_pushvalue (L, -3);
+        lua_pushlightuserdata (L, const_cast<ClassDescriptor*> (this));
+        lua_pushcclosure (L, NewIndex, 2);
+        lua_setfield (L, -3, "__newindex");
+
+        lua_pop (L, 1);
+    } else {
+        // create index table
+        lua_createtable (L, 0, entries.size ());
+        for (const auto &entry : entries) {
+            if (entry.fn->type == function::MEMBERFUNCTION) {
+                push_function (L, entry.fn, -3);
+                lua_setfield (L, -2, entry.name);
+            } else if (entry.fn->type == function::STATICFUNCTION) {
+                push_function (L, entry.fn, 0);
+                lua_setfield (L, -2, entry.name);
+            }
+        }
+        lua_setfield (L, -2, "__index");
+    }
+
+    // register descriptor for type checks
+    lua_pushlightuserdata (L, const_cast<ClassDescriptor*> (this));
+    lua_setfield (L, -2, "__ctypes");
+}
+
+void ClassDescriptor::push_class (lua_State *L) const noexcept
+{
+    // create table
+    lua_newtable (L);
+
+    // create metatable
+    lua_newtable (L);
+
+    // register static functions
+    for (const auto &entry : entries) {
+        if (entry.fn->type == function::STATICFUNCTION) {
+            push_function (L, entry.fn, 0);
+            lua_setfield (L, -3, entry.name);
+        }
+    }
+
+    // register constructor
+    if (constructor != nullptr) {
+        push_function (L, constructor, 0);
+        lua_setfield (L, -2, "__call");
+    }
+
+    // set metatable
+    lua_setmetatable (L, -2);
+}
+
+void ClassDescriptor::name_functions (const char *classname) const
+{
+    const std::string prefix = std::string (classname) + ".";
+    for (const auto &entry : entries) {
+        if (entry.slot) detail::NameFunction (entry.fn->func, prefix + entry.name);
+    }
+    for (auto meta : metafunctions) {
+        detail::NameFunction (meta->func, prefix + meta->name);
+    }
+    if (constructor != nullptr) {
+        detail::NameFunction (constructor->func, prefix + "constructor");
+    }
+}
+
+int ClassDescriptor::Index (lua_State *L)
+{
+    const ClassDescriptor *descriptor = static_cast<const ClassDescriptor*> (lua_touserdata (L, lua_upvalueindex (3)));
+    if (lua_type (L, 2) == LUA_TSTRING) {
+        std::size_t length = 0;
+        const char *name = lua_tolstring (L, 2, &length);
+        const Entry *entry = descriptor->find (name, length);
+        if (entry != nullptr) {
+            if (entry->slot) {
+                lua_rawgeti (L, lua_upvalueindex (2), entry->slot);
+                return 1;
+            }
+            if (entry->fn->func == nullptr) {
+                return luaL_error (L, "Property %s is write-only.", entry->name);
+            }
+            // accessors and index functions share upvalue 1 (the object) with this closure
+            return entry->fn->func (L);
+        }
+    }
+    if (descriptor->indexfn != nullptr) {
+        return descriptor->indexfn (L);
+    }
+    lua_pushnil (L);
+    return 1;
+}
+
+int ClassDescriptor::NewIndex (lua_State *L)
+{
+    const ClassDescriptor *descriptor = static_cast<const ClassDescriptor*> (lua_touserdata (L, lua_upvalueindex (2)));
+    if (lua_type (L, 2) == LUA_TSTRING) {
+        std::size_t length = 0;
+        const char *name = lua_tolstring (L, 2, &length);
+        const Entry *entry = descriptor->find (name, length);
+        if (entry != nullptr && entry->slot == 0) {
+            if (entry->fn->setfunc == nullptr) {
+                return luaL_error (L, "Property %s is read-only.", entry->name);
+            }
+            lua_settop (L, 3);
+            return entry->fn->setfunc (L);
+        }
+    }
+    if (descriptor->newindexfn != nullptr) {
+        return descriptor->newindexfn (L);
+    }
+    return luaL_error (L, "Cannot assign to %s.", lua_tostring (L, 2));
+}
+
+} /* namespace detail */
+} /* namespace lua */
@@ -0,0 +1,63 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "luawrapper.h"
+
+namespace lua {
+
+Coroutine::Coroutine (lua_State *L, const int &_index) : T (nullptr), started (false)
+{
+    int index = detail::abs_index (L, _index);
+    T = lua_newthread (L);
+    ref = Reference (L, -1);
+    lua_pop (L, 1);
+    lua_pushvalue (L, index);
+    lua_xmove (L, T, 1);
+}
+
+int Coroutine::resume_stack (int nargs)
+{
+    int status = lua_resume (T, nargs);
+    started = true;
+    return status;
+}
+
+Pending::Pending (lua_State *L) : T (L)
+{
+    if (lua_pushthread (L) == 1) {
+        lua_pop (L, 1);
+        throw std::runtime_error ("Cannot suspend the main thread.");
+    }
+    ref = Reference (L, -1);
+    lua_pop (L, 1);
+}
+
+int Pending::resume_stack (int nargs)
+{
+    int status = lua_resume (T, nargs);
+    ref.reset ();
+    T = nullptr;
+    return status;
+}
+
+} /* namespace lua */
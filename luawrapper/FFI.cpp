@@ -0,0 +1,59 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "luawrapper.h"
+
+namespace lua {
+
+void FFIExport::load (lua_State *L, const char *name) const
+{
+    StackGuard guard (L);
+
+    // load ffi module
+    lua_getglobal (L, "require");
+    lua_pushliteral (L, "ffi");
+    lua_call (L, 1, 1);
+    int ffi = lua_gettop (L);
+
+    // declare types
+    if (!declarations.empty ()) {
+        lua_getfield (L, ffi, "cdef");
+        lua_pushlstring (L, declarations.data (), declarations.size ());
+        lua_call (L, 1, 0);
+    }
+
+    // create table of function pointers
+    lua_createtable (L, 0, entries.size ());
+    lua_getfield (L, ffi, "cast");
+    for (const auto &entry : entries) {
+        lua_pushvalue (L, -1);
+        lua_pushlstring (L, entry.type.data (), entry.type.size ());
+        lua_pushlightuserdata (L, entry.ptr);
+        lua_call (L, 2, 1);
+        lua_setfield (L, -3, entry.name.c_str ());
+    }
+    lua_pop (L, 1);
+    lua_setglobal (L, name);
+}
+
+} /* namespace lua */
@@ -0,0 +1,85 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <new>
+#include "luawrapper.h"
+
+namespace lua {
+namespace detail {
+
+namespace {
+const char finalizerqueue_key = 0;
+} /* anonymous namespace */
+
+FinalizerQueue::~FinalizerQueue (void)
+{
+    drain (std::numeric_limits<std::size_t>::max ());
+}
+
+bool FinalizerQueue::push (void *obj, deleter fn) noexcept
+{
+    Node *node = new (std::nothrow) Node;
+    if (node == nullptr) return false;
+    node->obj = obj;
+    node->fn = fn;
+    node->next = head.load (std::memory_order_relaxed);
+    while (!head.compare_exchange_weak (node->next, node, std::memory_order_release, std::memory_order_relaxed));
+    return true;
+}
+
+std::size_t FinalizerQueue::drain (std::size_t budget)
+{
+    std::size_t count = 0;
+    while (count < budget) {
+        if (pending == nullptr) {
+            // take everything queued so far and restore queueing order
+            Node *node = head.exchange (nullptr, std::memory_order_acquire);
+            while (node != nullptr) {
+                Node *next = node->next;
+                node->next = pending;
+                pending = node;
+                node = next;
+            }
+            if (pending == nullptr) break;
+        }
+        Node *node = pending;
+        pending = node->next;
+        node->fn (node->obj);
+        delete node;
+        count++;
+    }
+    return count;
+}
+
+FinalizerQueue *GetFinalizerQueue (lua_State *L)
+{
+    return static_cast<FinalizerQueue*> (GetRegistryPointer (L, &finalizerqueue_key));
+}
+
+void SetFinalizerQueue (lua_State *L, FinalizerQueue *queue)
+{
+    SetRegistryPointer (L, &finalizerqueue_key, queue);
+}
+
+} /* namespace detail */
+} /* namespace lua */
@@ -0,0 +1,160 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <cstdlib>
+#include "luawrapper.h"
+
+namespace lua {
+
+namespace detail {
+
+void *GCState::Allocate (void *ud, void *ptr, std::size_t osize, std::size_t nsize)
+{
+    GCState *state = static_cast<GCState*> (ud);
+    if (ptr == nullptr) osize = 0;
+    if (nsize == 0) {
+        std::free (ptr);
+        state->inuse -= osize;
+        state->freed += osize;
+        return nullptr;
+    }
+    void *result = std::realloc (ptr, nsize);
+    if (result == nullptr) return nullptr;
+    state->inuse += nsize - osize;
+    if (nsize > osize) {
+        state->allocated += nsize - osize;
+    } else {
+        state->freed += osize - nsize;
+    }
+    return result;
+}
+
+} /* namespace detail */
+
+template<typename F>
+GC::Stats GC::run (F steps)
+{
+    std::size_t inuse = this->inuse (), freed = this->freed ();
+    auto start = std::chrono::steady_clock::now ();
+    Stats stats {0, 0, std::chrono::nanoseconds::zero (), 0, false};
+    steps (stats);
+    stats.duration = std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start);
+    stats.inuse = this->inuse ();
+    if (state != nullptr && state->counting) {
+        stats.freed = this->freed () - freed;
+    } else {
+        stats.freed = inuse > stats.inuse ? inuse - stats.inuse : 0;
+    }
+    if (state != nullptr && state->callback) {
+        state->callback (stats);
+    }
+    return stats;
+}
+
+GC::Stats GC::step (std::chrono::nanoseconds budget, int stepsize)
+{
+    return run ([&] (Stats &stats) {
+        auto start = std::chrono::steady_clock::now (), last = start;
+        std::chrono::steady_clock::duration longest (0);
+        do {
+            stats.cycle = lua_gc (L, LUA_GCSTEP, stepsize) != 0;
+            stats.steps++;
+            auto now = std::chrono::steady_clock::now ();
+            if (now - last > longest) longest = now - last;
+            last = now;
+        } while (!stats.cycle && (last - start) + longest <= budget);
+    });
+}
+
+GC::Stats GC::collect (void)
+{
+    return run ([&] (Stats &stats) {
+        lua_gc (L, LUA_GCCOLLECT, 0);
+        stats.steps = 1;
+        stats.cycle = true;
+    });
+}
+
+void GC::preset (Preset preset)
+{
+    static const struct { int pause, stepmul; } presets[] = {
+        { 200, 200 },   // DEFAULT
+        { 150, 100 },   // LOW_LATENCY
+        { 100, 400 },   // LOW_MEMORY
+        { 300, 200 }    // THROUGHPUT
+    };
+    pause (presets[preset].pause);
+    stepmul (presets[preset].stepmul);
+}
+
+int GC::pause (int value)
+{
+    return lua_gc (L, LUA_GCSETPAUSE, value);
+}
+
+int GC::stepmul (int value)
+{
+    return lua_gc (L, LUA_GCSETSTEPMUL, value);
+}
+
+void GC::stop (void)
+{
+    if (state == nullptr || state->stopdepth++ == 0) {
+        lua_gc (L, LUA_GCSTOP, 0);
+    }
+}
+
+void GC::restart (void)
+{
+    if (state == nullptr || (state->stopdepth > 0 && --state->stopdepth == 0)) {
+        lua_gc (L, LUA_GCRESTART, 0);
+    }
+}
+
+bool GC::stopped (void) const
+{
+    return state != nullptr && state->stopdepth > 0;
+}
+
+std::size_t GC::inuse (void) const
+{
+    if (state != nullptr && state->counting) return state->inuse;
+    return static_cast<std::size_t> (lua_gc (L, LUA_GCCOUNT, 0)) * 1024 + lua_gc (L, LUA_GCCOUNTB, 0);
+}
+
+std::size_t GC::allocated (void) const
+{
+    return state != nullptr && state->counting ? state->allocated : 0;
+}
+
+std::size_t GC::freed (void) const
+{
+    return state != nullptr && state->counting ? state->freed : 0;
+}
+
+void GC::on_stats (Callback callback)
+{
+    if (state != nullptr) state->callback = std::move (callback);
+}
+
+} /* namespace lua */
@@ -0,0 +1,75 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#if !defined (_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+#include "luawrapper.h"
+
+namespace lua {
+namespace detail {
+
+MappedFile::MappedFile (const std::string &path) : ptr (nullptr), len (0), ok (false)
+{
+#if !defined (_WIN32)
+    int fd = open (path.c_str (), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat (fd, &st) == 0) {
+        len = st.st_size;
+        if (len == 0) {
+            ok = true;
+        } else {
+            void *p = mmap (nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                ptr = static_cast<const char*> (p);
+                ok = true;
+            }
+        }
+    }
+    close (fd);
+#else
+    std::ifstream file (path, std::ios::binary);
+    if (!file) return;
+    buffer.assign (std::istreambuf_iterator<char> (file), std::istreambuf_iterator<char> ());
+    ptr = buffer.data ();
+    len = buffer.size ();
+    ok = true;
+#endif
+}
+
+MappedFile::~MappedFile (void)
+{
+#if !defined (_WIN32)
+    if (ptr != nullptr) munmap (const_cast<char*> (ptr), len);
+#endif
+}
+
+} /* namespace detail */
+} /* namespace lua */
@@ -0,0 +1,91 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "luawrapper.h"
+
+namespace lua {
+namespace detail {
+
+namespace {
+const char objectcounters_key = 0;
+} /* anonymous namespace */
+
+ObjectCounters *GetObjectCounters (lua_State *L)
+{
+    return static_cast<ObjectCounters*> (GetRegistryPointer (L, &objectcounters_key));
+}
+
+void SetObjectCounters (lua_State *L, ObjectCounters *counters)
+{
+    SetRegistryPointer (L, &objectcounters_key, counters);
+}
+
+void ObjectCounters::name (const ClassDescriptor &descriptor, const char *name)
+{
+    if (descriptor.id () == 0) return;
+    Counter &counter = get (descriptor);
+    if (counter.name.empty ()) counter.name = name;
+}
+
+std::vector<ObjectCount> ObjectCounters::counts (void) const
+{
+    std::vector<ObjectCount> result;
+    for (const auto &counter : counters) {
+        if (counter.created == 0) continue;
+        std::string name = counter.name;
+        if (name.empty ()) name = counter.type != nullptr ? counter.type : "?";
+        result.push_back (ObjectCount {name, counter.live, counter.created, counter.bytes});
+    }
+    return result;
+}
+
+} /* namespace detail */
+
+std::vector<ObjectCount> Objects::counts (lua_State *L)
+{
+    detail::ObjectCounters *counters = detail::GetObjectCounters (L);
+    return counters != nullptr ? counters->counts () : std::vector<ObjectCount> ();
+}
+
+int Objects::Counts (lua_State *L)
+{
+    std::vector<ObjectCount> counts = Objects::counts (L);
+    lua_createtable (L, 0, counts.size ());
+    for (const auto &count : counts) {
+        lua_createtable (L, 0, 3);
+        lua_pushnumber (L, count.live);
+        lua_setfield (L, -2, "live");
+        lua_pushnumber (L, count.created);
+        lua_setfield (L, -2, "created");
+        lua_pushnumber (L, count.bytes);
+        lua_setfield (L, -2, "bytes");
+        lua_setfield (L, -2, count.name.c_str ());
+    }
+    return 1;
+}
+
+functionlist Objects::lua_functions = {
+    { "counts", Objects::Counts, STATIC_FUNCTION },
+};
+
+} /* namespace lua */
@@ -0,0 +1,261 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "luawrapper.h"
+#if defined (LUAWRAPPER_PROFILE)
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace lua {
+
+struct Profiler::Class {
+    std::string name;
+    bool registered;
+    std::map<const function*, std::unique_ptr<Binding>> bindings;
+};
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::map<const functionlist*, std::unique_ptr<Profiler::Class>> classes;
+};
+
+Registry &GetRegistry (void) {
+    static Registry registry;
+    return registry;
+}
+
+int ThreadShard (void) {
+    static std::atomic<unsigned int> next (0);
+    thread_local int shard = next.fetch_add (1, std::memory_order_relaxed) % Profiler::SHARDS;
+    return shard;
+}
+
+int HighestBit (std::uint64_t v) {
+#if defined (__GNUC__)
+    return 63 - __builtin_clzll (v);
+#else
+    int i = 0;
+    while (v >>= 1) i++;
+    return i;
+#endif
+}
+
+void JsonString (std::ostream &out, const std::string &str) {
+    out << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char> (c) < 0x20) {
+            const char *hex = "0123456789abcdef";
+            out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} /* anonymous namespace */
+
+constexpr int Profiler::SUBBITS;
+constexpr int Profiler::SUBBUCKETS;
+constexpr int Profiler::BUCKETS;
+constexpr int Profiler::SHARDS;
+
+std::uint64_t Profiler::bucket_limit (int bucket)
+{
+    if (bucket < SUBBUCKETS) return bucket;
+    return static_cast<std::uint64_t> (SUBBUCKETS | (bucket & (SUBBUCKETS - 1))) << ((bucket >> SUBBITS) - 1);
+}
+
+int Profiler::bucket (std::uint64_t nanoseconds)
+{
+    if (nanoseconds < SUBBUCKETS) return static_cast<int> (nanoseconds);
+    int magnitude = HighestBit (nanoseconds);
+    int bucket = ((magnitude - SUBBITS + 1) << SUBBITS) + ((nanoseconds >> (magnitude - SUBBITS)) & (SUBBUCKETS - 1));
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+std::uint64_t Profiler::Statistics::percentile (double fraction) const
+{
+    std::uint64_t total = 0;
+    for (auto count : histogram) total += count;
+    if (total == 0) return 0;
+    std::uint64_t rank = static_cast<std::uint64_t> (fraction * total + 0.5), seen = 0;
+    if (rank == 0) rank = 1;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen >= rank) return i + 1 < BUCKETS ? bucket_limit (i + 1) - 1 : bucket_limit (i);
+    }
+    return bucket_limit (BUCKETS - 1);
+}
+
+std::vector<Profiler::Statistics> Profiler::statistics (void)
+{
+    std::vector<Statistics> result;
+    Registry &registry = GetRegistry ();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+    for (const auto &cls : registry.classes) {
+        for (const auto &entry : cls.second->bindings) {
+            const Binding &binding = *entry.second;
+            Statistics statistics { cls.second->name, binding.name, 0, 0, std::vector<std::uint64_t> (BUCKETS, 0) };
+            for (const auto &shard : binding.shards) {
+                statistics.calls += shard.calls.load (std::memory_order_relaxed);
+                statistics.failed += shard.failed.load (std::memory_order_relaxed);
+                for (int i = 0; i < BUCKETS; i++) {
+                    statistics.histogram[i] += shard.histogram[i].load (std::memory_order_relaxed);
+                }
+            }
+            if (statistics.calls > 0 || statistics.failed > 0) {
+                result.push_back (std::move (statistics));
+            }
+        }
+    }
+    return result;
+}
+
+std::string Profiler::json (void)
+{
+    std::ostringstream out;
+    out << "{\"bindings\":[";
+    bool first = true;
+    for (const auto &statistics : Profiler::statistics ()) {
+        out << (first ? "{" : ",{") << "\"class\":";
+        first = false;
+        JsonString (out, statistics.classname);
+        out << ",\"function\":";
+        JsonString (out, statistics.name);
+        out << ",\"calls\":" << statistics.calls << ",\"failed_checks\":" << statistics.failed
+            << ",\"p50_ns\":" << statistics.percentile (0.5) << ",\"p99_ns\":" << statistics.percentile (0.99)
+            << ",\"max_ns\":" << statistics.percentile (1.0) << ",\"histogram\":[";
+        bool firstbucket = true;
+        for (int i = 0; i < BUCKETS; i++) {
+            if (statistics.histogram[i] == 0) continue;
+            out << (firstbucket ? "[" : ",[") << bucket_limit (i) << "," << statistics.histogram[i] << "]";
+            firstbucket = false;
+        }
+        out << "]}";
+    }
+    out << "]}";
+    return out.str ();
+}
+
+std::string Profiler::text (void)
+{
+    std::ostringstream out;
+    for (const auto &statistics : Profiler::statistics ()) {
+        out << statistics.classname << "." << statistics.name << ": " << statistics.calls << " calls, "
+            << statistics.failed << " failed checks, p50 " << statistics.percentile (0.5) << " ns, p99 "
+            << statistics.percentile (0.99) << " ns, max " << statistics.percentile (1.0) << " ns\n";
+    }
+    return out.str ();
+}
+
+void Profiler::reset (void)
+{
+    Registry &registry = GetRegistry ();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+    for (const auto &cls : registry.classes) {
+        for (const auto &entry : cls.second->bindings) {
+            for (auto &shard : entry.second->shards) {
+                shard.calls.store (0, std::memory_order_relaxed);
+                shard.failed.store (0, std::memory_order_relaxed);
+                for (auto &count : shard.histogram) count.store (0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+Profiler::Class *Profiler::get_class (const functionlist &functions, const char *type)
+{
+    Registry &registry = GetRegistry ();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+    auto &cls = registry.classes[&functions];
+    if (!cls) {
+        cls.reset (new Class { type != nullptr ? type : "?", false, {} });
+    }
+    return cls.get ();
+}
+
+Profiler::Binding *Profiler::binding (Class *cls, const function &fn, const char *name, lua_CFunction func)
+{
+    Registry &registry = GetRegistry ();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+    auto &binding = cls->bindings[&fn];
+    if (!binding) {
+        binding.reset (new Binding);
+        binding->cls = cls;
+        binding->name = name;
+        binding->func = func;
+        for (auto &shard : binding->shards) {
+            shard.calls.store (0, std::memory_order_relaxed);
+            shard.failed.store (0, std::memory_order_relaxed);
+            for (auto &count : shard.histogram) count.store (0, std::memory_order_relaxed);
+        }
+    }
+    return binding.get ();
+}
+
+void Profiler::name_class (Class *cls, const char *name)
+{
+    Registry &registry = GetRegistry ();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+    if (!cls->registered) {
+        cls->name = name;
+        cls->registered = true;
+    }
+}
+
+void Profiler::failed_check (lua_State *L)
+{
+    // the binding is found through the running function rather than remembered by Call,
+    // which a lua error leaves without cleaning up; unprofiled wrappers are not counted
+    lua_Debug ar;
+    if (!lua_getstack (L, 0, &ar) || !lua_getinfo (L, "f", &ar)) return;
+    if (lua_tocfunction (L, -1) == Call && lua_getupvalue (L, -1, 2) != nullptr) {
+        Binding *binding = static_cast<Binding*> (lua_touserdata (L, -1));
+        if (binding != nullptr) binding->shards[ThreadShard ()].failed.fetch_add (1, std::memory_order_relaxed);
+        lua_pop (L, 1);
+    }
+    lua_pop (L, 1);
+}
+
+int Profiler::Call (lua_State *L)
+{
+    Binding *binding = static_cast<Binding*> (lua_touserdata (L, lua_upvalueindex (2)));
+    Binding::Shard &shard = binding->shards[ThreadShard ()];
+    shard.calls.fetch_add (1, std::memory_order_relaxed);
+    // calls ending with a lua error are counted but have no latency
+    auto start = std::chrono::steady_clock::now ();
+    int results = binding->func (L);
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start);
+    shard.histogram[bucket (elapsed.count ())].fetch_add (1, std::memory_order_relaxed);
+    return results;
+}
+
+} /* namespace lua */
+#endif
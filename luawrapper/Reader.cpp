@@ -0,0 +1,138 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#if !defined (_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <fcntl.h>
+#include <io.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include "luawrapper.h"
+
+namespace lua {
+
+constexpr std::size_t Reader::DEFAULT_BLOCK_SIZE;
+
+FileReader::FileReader (const std::string &path, std::size_t blocksize)
+    : fd (-1), owned (true), buffer (CheckBlockSize (blocksize))
+{
+#if !defined (_WIN32)
+    fd = open (path.c_str (), O_RDONLY | O_CLOEXEC);
+#else
+    fd = _open (path.c_str (), _O_RDONLY | _O_BINARY);
+#endif
+    if (fd < 0) throw std::runtime_error ("Cannot open " + path + ".");
+}
+
+FileReader::FileReader (int fd_, std::size_t blocksize)
+    : fd (fd_), owned (false), buffer (CheckBlockSize (blocksize))
+{
+}
+
+FileReader::~FileReader (void)
+{
+#if !defined (_WIN32)
+    if (owned) close (fd);
+#else
+    if (owned) _close (fd);
+#endif
+}
+
+const char *FileReader::read (std::size_t &size)
+{
+#if !defined (_WIN32)
+    ssize_t result;
+    do {
+        result = ::read (fd, buffer.data (), buffer.size ());
+    } while (result < 0 && errno == EINTR);
+#else
+    int result = _read (fd, buffer.data (), static_cast<unsigned int> (buffer.size ()));
+#endif
+    if (result < 0) throw std::runtime_error ("Cannot read file.");
+    size = result;
+    return buffer.data ();
+}
+
+MappedReader::MappedReader (const std::string &path, std::size_t blocksize_)
+    : file (path), offset (0), blocksize (CheckBlockSize (blocksize_))
+{
+    if (!file.valid ()) throw std::runtime_error ("Cannot open " + path + ".");
+}
+
+const char *MappedReader::read (std::size_t &size)
+{
+    size = std::min (blocksize, file.size () - offset);
+    const char *block = file.data () + offset;
+    offset += size;
+    return block;
+}
+
+const char *StreamReader::read (std::size_t &size)
+{
+    stream.read (buffer.data (), buffer.size ());
+    if (stream.bad ()) throw std::runtime_error ("Cannot read stream.");
+    size = stream.gcount ();
+    return buffer.data ();
+}
+
+namespace {
+
+struct ReaderState {
+    Reader &reader;
+    std::string error;
+};
+
+const char *ReadBlock (lua_State *L, void *ud, std::size_t *size)
+{
+    ReaderState *state = static_cast<ReaderState*> (ud);
+    // exceptions must not pass through lua_load
+    try {
+        const char *block = state->reader.read (*size);
+        return *size > 0 ? block : nullptr;
+    } catch (const std::exception &e) {
+        state->error = e.what ();
+    } catch (...) {
+        state->error = "unknown exception.";
+    }
+    *size = 0;
+    return nullptr;
+}
+
+} /* anonymous namespace */
+
+int State::load (Reader &reader, const std::string &chunkname)
+{
+    ReaderState state { reader, std::string () };
+    int status = lua_load (L, ReadBlock, &state, chunkname.c_str ());
+    if (!state.error.empty ()) {
+        lua_pop (L, 1);
+        lua_pushlstring (L, state.error.data (), state.error.size ());
+        return LUA_ERRFILE;
+    }
+    return status;
+}
+
+} /* namespace lua */
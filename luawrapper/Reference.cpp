@@ -21,61 +21,48 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <cstring>
 #include "luawrapper.h"
 
 namespace lua {
 
-Reference::Reference (lua_State *L_, const int &index) : L (L_), ptr (nullptr)
+Reference::Reference (lua_State *L_, const int &index) : L (L_), handle (nullptr), ptr (nullptr)
 {
-    lua_pushvalue (L, index);
-    ref = luaL_ref(L, LUA_REGISTRYINDEX);
-    if (lua_isuserdata (L, index)) {
-        ptr = reinterpret_cast<void**> (lua_touserdata (L, index));
+    if (!lua_isnil (L, index)) {
+        lua_pushvalue (L, index);
+        store ();
     }
 }
 
-Reference::Reference (const Reference &r) : L (r.L), ptr (r.ptr)
-{
-    if (r.valid ()) {
-        lua_rawgeti (L, LUA_REGISTRYINDEX, r.ref);
-        ref = luaL_ref (L, LUA_REGISTRYINDEX);
-    } else {
-        L = nullptr; ref = LUA_NOREF; ptr = nullptr;
-    }
-}
-
-Reference::Reference (const WeakReference &r) : L (r.L), ptr (nullptr), ref (LUA_NOREF)
+Reference::Reference (const WeakReference &r) : L (r.L), handle (nullptr), ptr (nullptr)
 {
     if (L) {
         r.push ();
-        if (lua_isuserdata (L, -1)) {
-            ptr = reinterpret_cast<void**> (lua_touserdata (L, -1));
+        if (lua_isnil (L, -1)) {
+            lua_pop (L, 1);
+        } else {
+            store ();
         }
-        ref = luaL_ref(L, LUA_REGISTRYINDEX);
     }
 }
 
 Reference &Reference::operator= (const Reference &r)
 {
+    if (r.handle != nullptr) r.handle->count++;
     reset ();
-    if (r.valid ()) {
-        L = r.L;
-        lua_rawgeti (L, LUA_REGISTRYINDEX, r.ref);
-        ref = luaL_ref (L, LUA_REGISTRYINDEX);
-        ptr = r.ptr;
-    }
+    L = r.L;
+    handle = r.handle;
+    ptr = r.ptr;
     return *this;
 }
-Reference::~Reference (void)
-{
-    reset ();
-}
 Reference &Reference::operator= (Reference &&r) noexcept
 {
-    reset ();
-    L= r.L; r.L = nullptr;
-    ref = r.ref; r.ref = LUA_NOREF;
-    ptr = r.ptr; r.ptr = nullptr;
+    if (this != &r) {
+        reset ();
+        L = r.L; r.L = nullptr;
+        handle = r.handle; r.handle = nullptr;
+        ptr = r.ptr; r.ptr = nullptr;
+    }
     return *this;
 }
 bool Reference::operator< (const Reference &r) const
@@ -96,42 +83,72 @@ bool Reference::operator== (const Reference &r) const
     if (ptr != r.ptr) return false;
     if (ptr != nullptr) return true;
     if (L != r.L) return false;
+    if (handle == r.handle) return true;
+    // only tables and userdata may have an __eq metamethod
+    if (type () != r.type ()) return false;
+    if (type () != LUA_TTABLE && type () != LUA_TUSERDATA) return identity () == r.identity ();
+    if (identity () == r.identity ()) return true;
     push ();
     r.push ();
     bool result = lua_equal (L, -1, -2);
     lua_pop (L, 2);
     return result;
 }
-void Reference::reset (void)
+void Reference::store (void)
 {
-    if (L != nullptr && ref != LUA_NOREF) {
-        luaL_unref (L, LUA_REGISTRYINDEX, ref);
+    // expects the non-nil value on top of the stack and pops it
+    int type = lua_type (L, -1);
+    std::uint64_t identity = 0;
+    switch (type) {
+    case LUA_TNUMBER: {
+        lua_Number n = lua_tonumber (L, -1);
+        if (n == 0) n = 0; // -0 equals 0
+        std::memcpy (&identity, &n, sizeof (n) < sizeof (identity) ? sizeof (n) : sizeof (identity));
+        break;
     }
-    L = nullptr;
-    ref = LUA_NOREF;
-    ptr = nullptr;
+    case LUA_TBOOLEAN:
+        identity = lua_toboolean (L, -1);
+        break;
+    case LUA_TSTRING:
+        // strings are interned, so equal strings share their storage
+        identity = reinterpret_cast<std::uintptr_t> (lua_tostring (L, -1));
+        break;
+    default:
+        identity = reinterpret_cast<std::uintptr_t> (lua_topointer (L, -1));
+        break;
+    }
+    if (lua_isuserdata (L, -1)) {
+        ptr = reinterpret_cast<void**> (lua_touserdata (L, -1));
+    }
+    handle = new Handle { luaL_ref (L, LUA_REGISTRYINDEX), 1, type, identity };
+}
+void Reference::release (void)
+{
+    luaL_unref (L, LUA_REGISTRYINDEX, handle->ref);
+    delete handle;
 }
 
 void Reference::push (void) const {
     if (L != nullptr) {
-        if (ref != LUA_NOREF && ref != LUA_REFNIL) {
-            lua_rawgeti (L, LUA_REGISTRYINDEX, ref);
+        if (handle != nullptr) {
+            lua_rawgeti (L, LUA_REGISTRYINDEX, handle->ref);
         } else {
             lua_pushnil (L);
         }
     }
 }
 
-bool Reference::isnil (void) const {
-    bool result = true;
-    if (L != nullptr) {
-        if (ref != LUA_NOREF && ref != LUA_REFNIL) {
-            lua_rawgeti (L, LUA_REGISTRYINDEX, ref);
-            result = lua_isnil (L, -1);
-            lua_pop (L, 1);
-        }
+void Reference::push (lua_State *L) const {
+    if (handle != nullptr) {
+        lua_rawgeti (L, LUA_REGISTRYINDEX, handle->ref);
+    } else {
+        lua_pushnil (L);
     }
-    return result;
+}
+
+bool Reference::isnil (void) const {
+    // only non-nil values are stored in the registry
+    return handle == nullptr;
 }
 
 } /* namespace lua */
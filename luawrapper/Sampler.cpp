@@ -0,0 +1,211 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include "luawrapper.h"
+
+namespace lua {
+
+namespace detail {
+
+namespace {
+struct FunctionNames {
+    std::mutex mutex;
+    std::unordered_map<std::uintptr_t, std::string> names;
+};
+FunctionNames &GetFunctionNames (void) {
+    static FunctionNames names;
+    return names;
+}
+} /* anonymous namespace */
+
+void NameFunction (lua_CFunction fn, const std::string &name)
+{
+    FunctionNames &names = GetFunctionNames ();
+    std::lock_guard<std::mutex> lock (names.mutex);
+    names.names.emplace (reinterpret_cast<std::uintptr_t> (fn), name);
+}
+
+bool GetFunctionName (lua_CFunction fn, std::string &name)
+{
+    FunctionNames &names = GetFunctionNames ();
+    std::lock_guard<std::mutex> lock (names.mutex);
+    auto it = names.names.find (reinterpret_cast<std::uintptr_t> (fn));
+    if (it == names.names.end ()) return false;
+    name = it->second;
+    return true;
+}
+
+} /* namespace detail */
+
+namespace {
+const char sampler_key = 0;
+} /* anonymous namespace */
+
+Sampler::Sampler (lua_State *L_, int interval_, int maxdepth_)
+    : L (L_), interval (interval_ > 0 ? interval_ : 1), maxdepth (maxdepth_), running (false),
+      prevhook (nullptr), prevmask (0), prevcount (0), prevsampler (nullptr), chaining (false), count (0)
+{
+    clear ();
+}
+
+Sampler::~Sampler (void)
+{
+    stop ();
+}
+
+void Sampler::start (void)
+{
+    if (running) return;
+    prevhook = lua_gethook (L);
+    prevmask = lua_gethookmask (L);
+    prevcount = lua_gethookcount (L);
+    prevsampler = detail::GetRegistryPointer (L, &sampler_key);
+    chaining = false;
+    detail::SetRegistryPointer (L, &sampler_key, this);
+    lua_sethook (L, hook, LUA_MASKCOUNT, interval);
+    running = true;
+}
+
+void Sampler::stop (void)
+{
+    if (!running) return;
+    // a budget that was exceeded meanwhile replaced the hook and restored its own predecessor
+    if (lua_gethook (L) == hook) lua_sethook (L, prevhook, prevmask, prevcount);
+    detail::SetRegistryPointer (L, &sampler_key, prevsampler);
+    running = false;
+}
+
+void Sampler::clear (void)
+{
+    count = 0;
+    frames.clear ();
+    frameindex.clear ();
+    nodes.assign (1, Node {0, 0, 0});
+    children.clear ();
+}
+
+void Sampler::hook (lua_State *L, lua_Debug *ar)
+{
+    Sampler *sampler = static_cast<Sampler*> (detail::GetRegistryPointer (L, &sampler_key));
+    if (sampler == nullptr || sampler->chaining) return;
+    sampler->sample (L);
+    // a nested sampler only samples into the innermost one
+    if (sampler->prevhook != nullptr && sampler->prevhook != hook && (sampler->prevmask & LUA_MASKCOUNT)) {
+        // an exceeded budget raises its error from here, after which the hook is replaced
+        sampler->chaining = true;
+        sampler->prevhook (L, ar);
+        sampler->chaining = false;
+    }
+}
+
+void Sampler::sample (lua_State *T)
+{
+    // innermost frame first
+    stack.clear ();
+    lua_Debug ar;
+    for (int level = 0; level < maxdepth && lua_getstack (T, level, &ar); level++) {
+        stack.push_back (intern (T, ar));
+    }
+    std::uint32_t node = 0;
+    for (auto it = stack.rbegin (); it != stack.rend (); ++it) {
+        std::uint64_t key = (static_cast<std::uint64_t> (node) << 32) | *it;
+        auto child = children.find (key);
+        if (child == children.end ()) {
+            child = children.emplace (key, static_cast<std::uint32_t> (nodes.size ())).first;
+            nodes.push_back (Node {node, *it, 0});
+        }
+        node = child->second;
+    }
+    nodes[node].count++;
+    count++;
+}
+
+std::uint32_t Sampler::intern (lua_State *T, lua_Debug &ar)
+{
+    lua_getinfo (T, "S", &ar);
+    lua_CFunction cfunction = nullptr;
+    std::pair<std::uintptr_t, int> key (reinterpret_cast<std::uintptr_t> (ar.source), ar.linedefined);
+    if (!std::strcmp (ar.what, "C")) {
+        lua_getinfo (T, "f", &ar);
+        cfunction = lua_tocfunction (T, -1);
+#if defined (LUAWRAPPER_PROFILE)
+        // name the function wrapped by the call profiler
+        if (cfunction == Profiler::Call && lua_getupvalue (T, -1, 2) != nullptr) {
+            cfunction = static_cast<Profiler::Binding*> (lua_touserdata (T, -1))->func;
+            lua_pop (T, 1);
+        }
+#endif
+        lua_pop (T, 1);
+        key = std::make_pair (reinterpret_cast<std::uintptr_t> (cfunction), -1);
+    }
+
+    auto it = frameindex.find (key);
+    if (it != frameindex.end ()) {
+        const Frame &frame = frames[it->second];
+        if (cfunction != nullptr || frame.source == ar.short_src) return it->second;
+    }
+
+    Frame frame { cfunction, ar.short_src, std::string () };
+    if (cfunction != nullptr) {
+        if (!detail::GetFunctionName (cfunction, frame.name)) {
+            std::ostringstream name;
+            name << "[C " << reinterpret_cast<void*> (reinterpret_cast<std::uintptr_t> (cfunction)) << "]";
+            frame.name = name.str ();
+        }
+    } else if (!std::strcmp (ar.what, "main")) {
+        frame.name = std::string ("main ") + ar.short_src;
+    } else {
+        frame.name = std::string (ar.short_src) + ":" + std::to_string (ar.linedefined);
+    }
+    // ';' separates frames in the folded format
+    std::replace (frame.name.begin (), frame.name.end (), ';', ',');
+    std::uint32_t id = static_cast<std::uint32_t> (frames.size ());
+    frames.push_back (std::move (frame));
+    frameindex[key] = id;
+    return id;
+}
+
+std::string Sampler::folded (void) const
+{
+    std::ostringstream out;
+    std::vector<std::uint32_t> path;
+    for (std::size_t i = 1; i < nodes.size (); i++) {
+        if (nodes[i].count == 0) continue;
+        path.clear ();
+        for (std::uint32_t node = i; node != 0; node = nodes[node].parent) {
+            path.push_back (nodes[node].frame);
+        }
+        for (auto it = path.rbegin (); it != path.rend (); ++it) {
+            if (it != path.rbegin ()) out << ';';
+            out << frames[*it].name;
+        }
+        out << ' ' << nodes[i].count << '\n';
+    }
+    return out.str ();
+}
+
+} /* namespace lua */
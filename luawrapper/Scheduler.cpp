@@ -0,0 +1,134 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#if defined (__linux__)
+#include <sys/eventfd.h>
+#endif
+#if !defined (_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include "luawrapper.h"
+
+namespace lua {
+
+Scheduler::Scheduler (void) : fds { -1, -1 }
+{
+#if defined (__linux__)
+    fds[0] = fds[1] = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fds[0] < 0) throw std::runtime_error ("Cannot create an eventfd.");
+#elif !defined (_WIN32)
+    if (pipe (fds) != 0) throw std::runtime_error ("Cannot create a pipe.");
+    for (int fd : fds) {
+        fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+        fcntl (fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+}
+
+Scheduler::~Scheduler (void)
+{
+#if !defined (_WIN32)
+    if (fds[0] >= 0) close (fds[0]);
+    if (fds[1] >= 0 && fds[1] != fds[0]) close (fds[1]);
+#endif
+}
+
+void Scheduler::post (Completion fn)
+{
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        // only the first completion of a batch needs to wake the loop
+        wake = queue.empty ();
+        queue.push_back (std::move (fn));
+    }
+    if (wake) signal ();
+}
+
+std::size_t Scheduler::run (void)
+{
+    std::vector<Completion> batch;
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        batch.swap (queue);
+        clear ();
+    }
+    std::size_t i = 0;
+    try {
+        for (; i < batch.size (); i++) batch[i] ();
+    } catch (...) {
+        // keep the completions not run yet, ahead of those posted meanwhile
+        std::lock_guard<std::mutex> lock (mutex);
+        queue.insert (queue.begin (), std::make_move_iterator (batch.begin () + i + 1),
+                      std::make_move_iterator (batch.end ()));
+        if (!queue.empty ()) signal ();
+        throw;
+    }
+    return batch.size ();
+}
+
+bool Scheduler::wait (int timeout)
+{
+#if !defined (_WIN32)
+    pollfd p { fds[0], POLLIN, 0 };
+    int result;
+    do {
+        result = poll (&p, 1, timeout);
+    } while (result < 0 && errno == EINTR);
+    return result > 0;
+#else
+    std::unique_lock<std::mutex> lock (mutex);
+    auto queued = [this] () { return !queue.empty (); };
+    if (timeout < 0) {
+        ready.wait (lock, queued);
+        return true;
+    }
+    return ready.wait_for (lock, std::chrono::milliseconds (timeout), queued);
+#endif
+}
+
+void Scheduler::signal (void)
+{
+#if !defined (_WIN32)
+    std::uint64_t one = 1;
+    while (write (fds[1], &one, sizeof (one)) < 0 && errno == EINTR);
+#else
+    ready.notify_all ();
+#endif
+}
+
+void Scheduler::clear (void)
+{
+#if !defined (_WIN32)
+    std::uint64_t value;
+    while (read (fds[0], &value, sizeof (value)) > 0);
+#endif
+}
+
+} /* namespace lua */
@@ -21,43 +21,64 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <cstdio>
 #include "luawrapper.h"
 
 namespace lua {
 
-State::State (void) : L (luaL_newstate ())
+namespace {
+int Panic (lua_State *L)
 {
-    if (L == nullptr) throw std::runtime_error ("Cannot create a lua state.");
-
-    // create empty table
-    lua_newtable (L);
-
-    // setup metatable for weak references
-    lua_newtable (L);
-    lua_pushliteral (L, "v");
-    lua_setfield (L, -2, "__mode");
-    lua_setmetatable (L, -2);
+    const char *msg = lua_tostring (L, -1);
+    std::fprintf (stderr, "PANIC: unprotected error in call to Lua API (%s)\n", msg != nullptr ? msg : "?");
+    return 0;
+}
+} /* anonymous namespace */
 
-    // store in registry
-    int ref = luaL_ref (L, LUA_REGISTRYINDEX);
-    if (ref != 1) {
-        throw std::runtime_error ("Unexpected registry key for weak reference table.");
+State::State (void) : L (nullptr), finalizers (new detail::FinalizerQueue),
+                      gcstate (new detail::GCState {0, 0, 0, true, 0, GC::Callback ()})
+{
+    L = lua_newstate (detail::GCState::Allocate, gcstate.get ());
+    if (L == nullptr) {
+        // LuaJIT on 64 bit platforms refuses custom allocators
+        gcstate->counting = false;
+        L = luaL_newstate ();
     }
+    if (L == nullptr) throw std::runtime_error ("Cannot create a lua state.");
+    lua_atpanic (L, Panic);
+
+    detail::SetFinalizerQueue (L, finalizers.get ());
+    objectcounters.reset (new detail::ObjectCounters);
+    detail::SetObjectCounters (L, objectcounters.get ());
+    timers.reset (new detail::TimerWheel (L));
+    detail::SetTimerWheel (L, timers.get ());
 }
 
-State::State (State &&state) : L (state.L)
+State::State (State &&state) : L (state.L), finalizers (std::move (state.finalizers)),
+                               timers (std::move (state.timers)), gcstate (std::move (state.gcstate)),
+                               objectcounters (std::move (state.objectcounters))
 {
     state.L = nullptr;
 }
 
 State::~State (void)
 {
+    // timers hold references into the state
+    timers.reset ();
     if (L) lua_close (L);
 }
 
 State &State::operator= (State &&state) noexcept
 {
+    if (this == &state) return *this;
+    // the allocator of the current state is replaced below
+    timers.reset ();
+    if (L) lua_close (L);
     L = state.L; state.L = nullptr;
+    finalizers = std::move (state.finalizers);
+    timers = std::move (state.timers);
+    gcstate = std::move (state.gcstate);
+    objectcounters = std::move (state.objectcounters);
     return *this;
 }
 
@@ -68,9 +89,24 @@ void State::loadlib (const lua_CFunction &fn, const std::string &name)
     lua_call (L, 1, 0);
 }
 
-void State::push_weak_registry (lua_State *L)
+std::size_t State::drain_finalizers (std::size_t budget)
+{
+    return finalizers ? finalizers->drain (budget) : 0;
+}
+
+std::vector<ObjectCount> State::objects (void) const
+{
+    return objectcounters ? objectcounters->counts () : std::vector<ObjectCount> ();
+}
+
+GC State::gc (void)
+{
+    return GC (L, gcstate.get ());
+}
+
+std::size_t State::run_timers (std::uint64_t now)
 {
-    lua_rawgeti (L, LUA_REGISTRYINDEX, 1);
+    return timers ? timers->run (now) : 0;
 }
 
 } /* namespace lua */
@@ -0,0 +1,72 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "luawrapper.h"
+
+namespace lua {
+
+Key::Key (lua_State *L, const char *name)
+{
+    lua_pushstring (L, name);
+    ref = Reference (L, -1);
+    lua_pop (L, 1);
+}
+
+Key::Key (lua_State *L, const std::string &name)
+{
+    lua_pushlstring (L, name.data (), name.size ());
+    ref = Reference (L, -1);
+    lua_pop (L, 1);
+}
+
+Table Table::create (lua_State *L, int narr, int nrec)
+{
+    lua_createtable (L, narr, nrec);
+    Table table (Reference (L, -1));
+    lua_pop (L, 1);
+    return table;
+}
+
+void Table::push (void) const
+{
+    if (L == nullptr) return;
+    if (index != 0) {
+        lua_pushvalue (L, index);
+    } else {
+        ref.push ();
+    }
+}
+
+std::size_t Table::size (void) const
+{
+    StackHelper stackhelper (this);
+    return lua_objlen (L, stackhelper.index);
+}
+
+Reference Table::reference (void) const
+{
+    if (index == 0) return ref;
+    return Reference (L, index);
+}
+
+} /* namespace lua */
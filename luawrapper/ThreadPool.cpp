@@ -0,0 +1,89 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "luawrapper.h"
+
+namespace lua {
+
+ThreadPool::ThreadPool (lua_State *L_) : L (L_), count (0)
+{
+    lua_newtable (L);
+    table = luaL_ref (L, LUA_REGISTRYINDEX);
+
+    // metatable of per request environments
+    lua_createtable (L, 0, 1);
+    lua_pushvalue (L, LUA_GLOBALSINDEX);
+    lua_setfield (L, -2, "__index");
+    envmeta = luaL_ref (L, LUA_REGISTRYINDEX);
+}
+
+ThreadPool::~ThreadPool (void)
+{
+    luaL_unref (L, LUA_REGISTRYINDEX, table);
+    luaL_unref (L, LUA_REGISTRYINDEX, envmeta);
+}
+
+ThreadPool::Thread ThreadPool::acquire (bool env)
+{
+    Thread thread;
+    lua_rawgeti (L, LUA_REGISTRYINDEX, table);
+    if (free.empty ()) {
+        thread.slot = ++count;
+        thread.L = lua_newthread (L);
+        lua_rawseti (L, -2, thread.slot);
+    } else {
+        thread.slot = free.back ();
+        free.pop_back ();
+        lua_rawgeti (L, -1, thread.slot);
+        thread.L = lua_tothread (L, -1);
+        lua_pop (L, 1);
+    }
+    lua_pop (L, 1);
+    if (env) {
+        lua_newtable (thread.L);
+        lua_rawgeti (thread.L, LUA_REGISTRYINDEX, envmeta);
+        lua_setmetatable (thread.L, -2);
+        lua_replace (thread.L, LUA_GLOBALSINDEX);
+    }
+    return thread;
+}
+
+void ThreadPool::release (const Thread &thread)
+{
+    lua_rawgeti (L, LUA_REGISTRYINDEX, table);
+    if (lua_status (thread.L) != 0) {
+        // suspended or dead threads cannot be reset, so the slot gets a new thread
+        lua_newthread (L);
+        lua_rawseti (L, -2, thread.slot);
+    } else {
+        lua_settop (thread.L, 0);
+        // restore the shared globals
+        lua_pushvalue (L, LUA_GLOBALSINDEX);
+        lua_xmove (L, thread.L, 1);
+        lua_replace (thread.L, LUA_GLOBALSINDEX);
+    }
+    lua_pop (L, 1);
+    free.push_back (thread.slot);
+}
+
+} /* namespace lua */
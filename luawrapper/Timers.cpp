@@ -0,0 +1,249 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "luawrapper.h"
+
+namespace lua {
+namespace detail {
+
+namespace {
+const char timerwheel_key = 0;
+
+int LowestBit (std::uint64_t v) {
+#if defined (__GNUC__)
+    return __builtin_ctzll (v);
+#else
+    int i = 0;
+    while (!(v & 1)) { v >>= 1; i++; }
+    return i;
+#endif
+}
+std::string ErrorMessage (lua_State *T) {
+    const char *msg = lua_tostring (T, -1);
+    return msg != nullptr ? msg : "Lua error in timer.";
+}
+} /* anonymous namespace */
+
+constexpr int TimerWheel::BITS;
+constexpr int TimerWheel::SLOTS;
+constexpr int TimerWheel::LEVELS;
+
+TimerWheel::TimerWheel (lua_State *L_) : L (L_), wheel {}, occupied {}, overflow (nullptr), current (0), count (0)
+{
+}
+
+TimerWheel::~TimerWheel (void)
+{
+    for (auto &level : wheel) {
+        for (Timer *slot : level) {
+            while (slot != nullptr) {
+                Timer *next = slot->next;
+                delete slot;
+                slot = next;
+            }
+        }
+    }
+    while (overflow != nullptr) {
+        Timer *next = overflow->next;
+        delete overflow;
+        overflow = next;
+    }
+}
+
+void TimerWheel::resume (std::uint64_t delay, Pending &&pending)
+{
+    insert (new Timer { current + (delay > 0 ? delay : 1), 0, std::move (pending), Reference (), nullptr });
+    count++;
+}
+
+void TimerWheel::call (std::uint64_t delay, std::uint64_t period, Reference &&fn)
+{
+    insert (new Timer { current + (delay > 0 ? delay : 1), period, Pending (), std::move (fn), nullptr });
+    count++;
+}
+
+void TimerWheel::insert (Timer *timer)
+{
+    // the highest digit in which due and current differ selects the level
+    std::uint64_t diff = timer->due ^ current;
+    for (int level = 0; level < LEVELS; level++) {
+        if ((diff >> (BITS * (level + 1))) == 0) {
+            int slot = (timer->due >> (BITS * level)) & (SLOTS - 1);
+            timer->next = wheel[level][slot];
+            wheel[level][slot] = timer;
+            occupied[level] |= std::uint64_t (1) << slot;
+            return;
+        }
+    }
+    timer->next = overflow;
+    overflow = timer;
+}
+
+void TimerWheel::cascade (int level)
+{
+    Timer *timer;
+    if (level < LEVELS) {
+        int slot = (current >> (BITS * level)) & (SLOTS - 1);
+        timer = wheel[level][slot];
+        wheel[level][slot] = nullptr;
+        occupied[level] &= ~(std::uint64_t (1) << slot);
+    } else {
+        timer = overflow;
+        overflow = nullptr;
+    }
+    while (timer != nullptr) {
+        Timer *next = timer->next;
+        insert (timer);
+        timer = next;
+    }
+}
+
+std::uint64_t TimerWheel::next_event (void) const
+{
+    // first occupied slot after the current one at each level, or the next top level block for overflows
+    std::uint64_t next = overflow != nullptr ? ((current >> (BITS * LEVELS)) + 1) << (BITS * LEVELS) : 0;
+    for (int level = 0; level < LEVELS; level++) {
+        int digit = (current >> (BITS * level)) & (SLOTS - 1);
+        if (digit == SLOTS - 1) continue;
+        std::uint64_t later = occupied[level] & ~((std::uint64_t (2) << digit) - 1);
+        if (later == 0) continue;
+        std::uint64_t block = (current >> (BITS * (level + 1))) << (BITS * (level + 1));
+        std::uint64_t t = block + (std::uint64_t (LowestBit (later)) << (BITS * level));
+        if (next == 0 || t < next) next = t;
+    }
+    return next;
+}
+
+bool TimerWheel::fire (Timer *timer, std::string &error)
+{
+    int status;
+    if (timer->fn.valid ()) {
+        timer->fn.push ();
+        Coroutine coroutine (L, -1);
+        lua_pop (L, 1);
+        status = coroutine.resume ();
+        if ((status == 0 || status == LUA_YIELD) && timer->period != 0) {
+            lua_State *T = coroutine.thread ();
+            bool stop = status == 0 && lua_gettop (T) > 0 && lua_isboolean (T, 1) && !lua_toboolean (T, 1);
+            if (!stop) {
+                timer->due = current + timer->period;
+                insert (timer);
+                return true;
+            }
+        }
+        if (status != 0 && status != LUA_YIELD && error.empty ()) {
+            error = ErrorMessage (coroutine.thread ());
+        }
+    } else {
+        lua_State *T = timer->pending.thread ();
+        status = timer->pending.resume ();
+        if (status != 0 && status != LUA_YIELD && error.empty ()) {
+            error = ErrorMessage (T);
+        }
+    }
+    delete timer;
+    count--;
+    return false;
+}
+
+std::size_t TimerWheel::run (std::uint64_t now)
+{
+    std::size_t fired = 0;
+    std::string error;
+    while (current < now) {
+        std::uint64_t next = count > 0 ? next_event () : 0;
+        if (next == 0 || next > now) {
+            current = now;
+            break;
+        }
+        current = next;
+        // cascade from the highest level whose lower digits wrapped to zero
+        for (int level = LEVELS; level > 0; level--) {
+            if ((current & ((std::uint64_t (1) << (BITS * level)) - 1)) == 0) cascade (level);
+        }
+        int slot = current & (SLOTS - 1);
+        Timer *timer = wheel[0][slot];
+        wheel[0][slot] = nullptr;
+        occupied[0] &= ~(std::uint64_t (1) << slot);
+        while (timer != nullptr) {
+            Timer *next = timer->next;
+            fire (timer, error);
+            fired++;
+            timer = next;
+        }
+    }
+    if (!error.empty ()) throw std::runtime_error (error);
+    return fired;
+}
+
+TimerWheel *GetTimerWheel (lua_State *L)
+{
+    return static_cast<TimerWheel*> (GetRegistryPointer (L, &timerwheel_key));
+}
+
+void SetTimerWheel (lua_State *L, TimerWheel *wheel)
+{
+    SetRegistryPointer (L, &timerwheel_key, wheel);
+}
+
+namespace {
+TimerWheel &CheckTimerWheel (lua_State *L) {
+    TimerWheel *wheel = GetTimerWheel (L);
+    if (wheel == nullptr) throw std::runtime_error ("Timers require a lua::State.");
+    return *wheel;
+}
+void CheckFunction (const StackReference &fn) {
+    if (!lua_isfunction (fn.GetLuaState (), fn.GetIndex ())) throw std::runtime_error ("Function expected.");
+}
+} /* anonymous namespace */
+
+} /* namespace detail */
+
+Pending Timers::sleep (lua_State *L, lua_Integer ms)
+{
+    // rejects callers outside a coroutine before anything is scheduled
+    Pending pending (L);
+    detail::CheckTimerWheel (L).resume (ms > 0 ? ms : 0, std::move (pending));
+    return Pending ();
+}
+
+void Timers::after (lua_State *L, lua_Integer ms, StackReference fn)
+{
+    detail::CheckFunction (fn);
+    detail::CheckTimerWheel (L).call (ms > 0 ? ms : 0, 0, fn.promote ());
+}
+
+void Timers::every (lua_State *L, lua_Integer ms, StackReference fn)
+{
+    detail::CheckFunction (fn);
+    std::uint64_t period = ms > 0 ? ms : 1;
+    detail::CheckTimerWheel (L).call (period, period, fn.promote ());
+}
+
+functionlist Timers::lua_functions = {
+    { "sleep", Function<Pending(lua_State*, lua_Integer)>::Wrap<&Timers::sleep>, STATIC_FUNCTION },
+    { "after", Function<void(lua_State*, lua_Integer, StackReference)>::Wrap<&Timers::after>, STATIC_FUNCTION },
+    { "every", Function<void(lua_State*, lua_Integer, StackReference)>::Wrap<&Timers::every>, STATIC_FUNCTION },
+};
+
+} /* namespace lua */
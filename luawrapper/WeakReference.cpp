@@ -24,36 +24,81 @@
 #include "luawrapper.h"
 
 namespace lua {
+namespace detail {
 
+namespace {
+const char weaktable_key = 0;
+} /* anonymous namespace */
 
-WeakReference::WeakReference (lua_State *L_, const int &index) : L (L_)
+constexpr int WeakTable::SENTINEL;
+
+WeakTable *GetWeakTable (lua_State *L)
+{
+    WeakTable *table = static_cast<WeakTable*> (GetRegistryPointer (L, &weaktable_key));
+    if (table != nullptr) return table;
+
+    // create empty table
+    lua_newtable (L);
+
+    // setup metatable for weak references
+    lua_newtable (L);
+    lua_pushliteral (L, "v");
+    lua_setfield (L, -2, "__mode");
+    lua_setmetatable (L, -2);
+
+    // add sentinel
+    lua_newtable (L);
+    lua_rawseti (L, -2, WeakTable::SENTINEL);
+
+    // store in registry
+    int ref = luaL_ref (L, LUA_REGISTRYINDEX);
+
+    // anchor description in the registry
+    lua_pushlightuserdata (L, const_cast<char*> (&weaktable_key));
+    table = static_cast<WeakTable*> (lua_newuserdata (L, sizeof (WeakTable)));
+    table->ref = ref;
+    table->generation = 1;
+    lua_rawset (L, LUA_REGISTRYINDEX);
+    return table;
+}
+
+} /* namespace detail */
+
+void WeakReference::assign (lua_State *L_, const int &index)
 {
-    State::push_weak_registry (L);
-    lua_pushvalue (L, index < 0 ? index - 1 : index);
+    // expects the value at a positive stack index
+    L = L_;
+    table = detail::GetWeakTable (L);
+    lua_rawgeti (L, LUA_REGISTRYINDEX, table->ref);
+    table->update (L);
+    lua_pushvalue (L, index);
     ref = luaL_ref (L, -2);
+    validgeneration = ref == LUA_REFNIL ? 0 : table->generation;
     lua_pop (L, 1);
 }
 
+WeakReference::WeakReference (lua_State *L_, const int &index) : L (nullptr), ref (LUA_NOREF), table (nullptr),
+                                                                 validgeneration (0)
+{
+    assign (L_, detail::abs_index (L_, index));
+}
 
-WeakReference::WeakReference (const WeakReference &r) : L (r.L)
+WeakReference::WeakReference (const WeakReference &r) : L (nullptr), ref (LUA_NOREF), table (nullptr),
+                                                        validgeneration (0)
 {
     if (r.valid ()) {
-        State::push_weak_registry (L);
-        lua_rawgeti (L, -1, r.ref);
-        ref = luaL_ref (L, -2);
+        r.push ();
+        assign (r.L, lua_gettop (r.L));
         lua_pop (L, 1);
-    } else {
-        L = nullptr; ref = LUA_NOREF;
     }
 }
-WeakReference::WeakReference (const Reference &r) : L (r.L) {
+WeakReference::WeakReference (const Reference &r) : L (nullptr), ref (LUA_NOREF), table (nullptr),
+                                                    validgeneration (0)
+{
     if (r.valid ()) {
-        State::push_weak_registry (L);
-        lua_rawgeti (L, LUA_REGISTRYINDEX, r.ref);
-        ref = luaL_ref (L, -2);
+        r.push ();
+        assign (r.L, lua_gettop (r.L));
         lua_pop (L, 1);
-    } else {
-        L = nullptr; ref = LUA_NOREF;
     }
 }
 WeakReference::~WeakReference (void)
@@ -62,59 +107,100 @@ WeakReference::~WeakReference (void)
 }
 WeakReference &WeakReference::operator= (const WeakReference &r)
 {
-    reset ();
-    if (r.valid ()) {
-        L = r.L;
-        State::push_weak_registry (L);
-        lua_rawgeti (L, -1, r.ref);
-        ref = luaL_ref (L, -2);
-        lua_pop (L, 1);
+    if (this != &r) {
+        reset ();
+        if (r.valid ()) {
+            r.push ();
+            assign (r.L, lua_gettop (r.L));
+            lua_pop (L, 1);
+        }
     }
     return *this;
 }
 WeakReference &WeakReference::operator= (const Reference &r) {
+    reset ();
     if (r.valid ()) {
-        L = r.L;
-        State::push_weak_registry (L);
-        lua_rawgeti (L, LUA_REGISTRYINDEX, r.ref);
-        ref = luaL_ref (L, -2);
+        r.push ();
+        assign (r.L, lua_gettop (r.L));
         lua_pop (L, 1);
-    } else {
-        L = nullptr; ref = LUA_NOREF;
     }
     return *this;
 }
 WeakReference &WeakReference::operator= (WeakReference &&r) noexcept
 {
-    reset ();
-    L= r.L; r.L = nullptr;
-    ref = r.ref; r.ref = LUA_NOREF;
+    if (this != &r) {
+        reset ();
+        L = r.L; r.L = nullptr;
+        ref = r.ref; r.ref = LUA_NOREF;
+        table = r.table; r.table = nullptr;
+        validgeneration = r.validgeneration;
+    }
     return *this;
 }
 bool WeakReference::valid (void) const
 {
     if (L == nullptr || ref == LUA_NOREF || ref == LUA_REFNIL) return false;
-    State::push_weak_registry (L);
-    lua_rawgeti (L, -1, ref);
-    bool v = !lua_isnil (L, -1);
-    lua_pop (L, 2);
+    lua_rawgeti (L, LUA_REGISTRYINDEX, table->ref);
+    table->update (L);
+    bool v = validgeneration == table->generation;
+    if (!v) {
+        lua_rawgeti (L, -1, ref);
+        v = !lua_isnil (L, -1);
+        if (v) validgeneration = table->generation;
+        lua_pop (L, 1);
+    }
+    lua_pop (L, 1);
     return v;
 }
+std::size_t WeakReference::valid (const WeakReference *refs, std::size_t count, bool *results)
+{
+    std::size_t n = 0;
+    lua_State *current = nullptr;
+    for (std::size_t i = 0; i < count; i++) {
+        const WeakReference &r = refs[i];
+        results[i] = false;
+        if (r.L == nullptr || r.ref == LUA_NOREF || r.ref == LUA_REFNIL) continue;
+        if (r.L != current) {
+            // fetch the weak table of the next state
+            if (current != nullptr) lua_pop (current, 1);
+            current = r.L;
+            lua_rawgeti (current, LUA_REGISTRYINDEX, r.table->ref);
+            r.table->update (current);
+        }
+        if (r.validgeneration != r.table->generation) {
+            lua_rawgeti (current, -1, r.ref);
+            if (!lua_isnil (current, -1)) r.validgeneration = r.table->generation;
+            lua_pop (current, 1);
+        }
+        results[i] = r.validgeneration == r.table->generation;
+        if (results[i]) n++;
+    }
+    if (current != nullptr) lua_pop (current, 1);
+    return n;
+}
+unsigned int WeakReference::generation (lua_State *L)
+{
+    detail::WeakTable *table = detail::GetWeakTable (L);
+    lua_rawgeti (L, LUA_REGISTRYINDEX, table->ref);
+    table->update (L);
+    lua_pop (L, 1);
+    return table->generation;
+}
 void WeakReference::reset (void)
 {
     if (L != nullptr && ref != LUA_NOREF) {
-        State::push_weak_registry (L);
+        lua_rawgeti (L, LUA_REGISTRYINDEX, table->ref);
         luaL_unref (L, -1, ref);
         lua_pop (L, 1);
-        L = nullptr; ref = LUA_NOREF;
     }
+    L = nullptr; ref = LUA_NOREF; table = nullptr; validgeneration = 0;
 }
 
 void WeakReference::push (void) const
 {
     if (L != nullptr) {
         if (ref != LUA_NOREF && ref != LUA_REFNIL) {
-            State::push_weak_registry (L);
+            lua_rawgeti (L, LUA_REGISTRYINDEX, table->ref);
             lua_rawgeti (L, -1, ref);
             lua_remove (L, -2);
         } else {
@@ -123,6 +209,17 @@ void WeakReference::push (void) const
     }
 }
 
+void WeakReference::push (lua_State *L_) const
+{
+    if (L != nullptr && ref != LUA_NOREF && ref != LUA_REFNIL) {
+        lua_rawgeti (L_, LUA_REGISTRYINDEX, table->ref);
+        lua_rawgeti (L_, -1, ref);
+        lua_remove (L_, -2);
+    } else {
+        lua_pushnil (L_);
+    }
+}
+
 WeakReference Type<WeakReference>::pull (lua_State *L, const int &index)
 {
     return WeakReference (L, index);
@@ -130,9 +227,7 @@ WeakReference Type<WeakReference>::pull (lua_State *L, const int &index)
 
 void Type<WeakReference>::push (lua_State *L, const WeakReference &v)
 {
-    State::push_weak_registry (L);
-    lua_rawgeti (L, -1, v.ref);
-    lua_remove (L, -2);
+    v.push (L);
 }
 
 } /* namespace lua */
@@ -0,0 +1,76 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstdint>
+
+namespace lua {
+
+// Instruction and wall time budget for running scripts. During pcall and resume a count
+// hook fires every granularity instructions and stops the script once it has run more
+// than instructions instructions or for longer than timeout; 0 means unlimited. Every call
+// gets the full budget. The hook covers the thread the call runs on and the coroutines
+// created during the call; any hook set before is restored afterwards. A count hook set
+// before, e.g. by a running Sampler, keeps being called every granularity instructions.
+class Budget {
+public:
+    enum Mode { ABORT, YIELD };
+    struct Usage {
+        // counted in multiples of the granularity
+        std::uint64_t instructions;
+        std::chrono::nanoseconds elapsed;
+        bool exceeded;
+    };
+    Budget (std::uint64_t instructions, std::chrono::nanoseconds timeout, Mode mode = ABORT, int granularity = 1000);
+    Budget (const Budget&) = delete;
+    Budget &operator= (const Budget&) = delete;
+    // like lua_pcall; a script over budget always raises an error
+    int pcall (lua_State *L, int nargs, int nresults, int errfunc = 0);
+    // like lua_resume on the coroutine T; a script over budget yields no values in YIELD mode
+    // and raises an error in ABORT mode or where it cannot yield
+    int resume (lua_State *T, int nargs);
+    // usage of the last call and of all calls
+    const Usage &last (void) const { return usage; }
+    const Usage &total (void) const { return totals; }
+private:
+    typedef std::chrono::steady_clock clock;
+    static void hook (lua_State *L, lua_Debug *ar);
+    void begin (lua_State *L, bool yield);
+    int end (lua_State *L, int status);
+    std::uint64_t quota;
+    std::chrono::nanoseconds timeout;
+    Mode mode;
+    int granularity;
+    Usage usage, totals;
+    // state of the running call
+    lua_State *thread;
+    bool yielding;
+    clock::time_point start, deadline;
+    lua_Hook prevhook;
+    int prevmask, prevcount;
+    void *prevbudget;
+    // set while the previous hook runs, which may lead back to this hook
+    bool chaining;
+};
+
+} /* namespace lua */
@@ -43,6 +43,11 @@ private:
         (t->*fn) (arghandler<S>::get (L, startindex)...);
         return 0;
     }
+    template<typename R, typename FN, int ...S>
+    static int do_call (if_pending_t<R, lua_State> *L, int startindex, T *t, FN fn, seq<S...>) {
+        (t->*fn) (arghandler<S>::get (L, startindex)...);
+        return lua_yield (L, 0);
+    }
     template<int ...S>
     static bool checkargs (lua_State *L, int startindex, seq<S...>) {
         if (lua_gettop (L) != startindex + sizeof... (Args) - 1) return false;
@@ -51,7 +56,12 @@ private:
 public:
     template<typename FN>
     static bool try_call (lua_State *L, int &results, int startindex, T *t, FN fn) {
-        if (!checkargs (L, startindex, typename gens<sizeof...(Args)>::type ())) return false;
+        if (!checkargs (L, startindex, typename gens<sizeof...(Args)>::type ())) {
+#if defined (LUAWRAPPER_PROFILE)
+            Profiler::failed_check (L);
+#endif
+            return false;
+        }
         try {
             results = do_call<Retval> (L, startindex, t, fn, typename gens<sizeof...(Args)>::type ());
         } catch (const std::exception &e) {
@@ -89,6 +99,11 @@ private:
         (*fn) (arghandler<S>::get (L, startindex)...);
         return 0;
     }
+    template<typename R, typename FN, int ...S>
+    static int do_call (if_pending_t<R, lua_State> *L, int startindex, FN fn, seq<S...>) {
+        (*fn) (arghandler<S>::get (L, startindex)...);
+        return lua_yield (L, 0);
+    }
     template<int ...S>
     static bool checkargs (lua_State *L, int startindex, seq<S...>) {
         if (lua_gettop (L) != startindex + sizeof... (Args) - 1) return false;
@@ -97,7 +112,12 @@ private:
 public:
     template<typename FN>
     static bool try_call (lua_State *L, int &results, int startindex, FN fn) {
-        if (!checkargs (L, startindex, typename gens<sizeof...(Args)>::type ())) return false;
+        if (!checkargs (L, startindex, typename gens<sizeof...(Args)>::type ())) {
+#if defined (LUAWRAPPER_PROFILE)
+            Profiler::failed_check (L);
+#endif
+            return false;
+        }
         try {
             results = do_call<Retval> (L, startindex, fn, typename gens<sizeof...(Args)>::type ());
         } catch (const std::exception &e) {
@@ -0,0 +1,131 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace lua {
+namespace detail {
+
+// Flattened description of a class and all its base classes, built once per class on first use.
+// Entries of a class take precedence over the entries of its base classes and earlier base
+// classes take precedence over later ones; within a single function list later entries replace
+// earlier ones with the same name. Only the destructor and constructor of the class itself are used.
+// Classes with properties or an index function resolve their members with a perfect hash table.
+class ClassDescriptor {
+public:
+    struct Entry {
+        const char *name;
+        std::size_t length;
+        const function *fn;
+        // position of the method closure in the member table or 0 for properties
+        int slot;
+    };
+    ClassDescriptor (const functionlist &functions, const size_t &typehash, const char *type = nullptr);
+    ClassDescriptor (const ClassDescriptor&) = delete;
+    ClassDescriptor &operator= (const ClassDescriptor&) = delete;
+    template<typename T>
+    static const ClassDescriptor &get (void) {
+        static const ClassDescriptor descriptor (Functions<T>::value, typeid (T).hash_code (), typeid (T).name ());
+        return descriptor;
+    }
+    // sequential number of descriptors of types, starting at 1, or 0 for plain function lists
+    std::size_t id (void) const {
+        return index;
+    }
+    // type name of the class, if known
+    const char *type_name (void) const {
+        return type;
+    }
+    bool derives (const size_t &typehash) const {
+        return std::binary_search (typehashs.begin (), typehashs.end (), typehash);
+    }
+    // whether members are resolved by the dispatcher, i.e. the class has properties or an index function
+    bool dispatching (void) const {
+        return hasproperties || indexfn != nullptr;
+    }
+    const Entry *find (const char *name, std::size_t length) const {
+        if (table.empty ()) return nullptr;
+        std::uint64_t h = hash (name, length);
+        std::uint32_t f1 = static_cast<std::uint32_t> (h);
+        std::uint32_t f2 = static_cast<std::uint32_t> (h >> 32) | 1;
+        std::uint32_t d = displacements[f1 % displacements.size ()];
+        const Entry *entry = table[(f1 + d * f2) & (table.size () - 1)];
+        if (entry == nullptr || entry->length != length || std::memcmp (entry->name, name, length)) {
+            return nullptr;
+        }
+        return entry;
+    }
+    void push_metatable (lua_State *L, bool destructor) const noexcept;
+    void push_class (lua_State *L) const noexcept;
+    // names the bound functions for Sampler
+    void name_functions (const char *classname) const;
+#if defined (LUAWRAPPER_PROFILE)
+    Profiler::Class *profile (void) const {
+        return profileclass;
+    }
+#endif
+private:
+    static std::uint64_t hash (const char *name, std::size_t length) {
+        // FNV-1a
+        std::uint64_t h = 14695981039346656037ull;
+        for (std::size_t i = 0; i < length; i++) {
+            h ^= static_cast<unsigned char> (name[i]);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+    void add (const functionlist &functions, bool own);
+    bool build (std::size_t tablesize);
+    // pushes fn, as closure over the value at index unless index is 0
+    void push_function (lua_State *L, const function *fn, int index) const noexcept;
+    static int Index (lua_State *L);
+    static int NewIndex (lua_State *L);
+    std::vector<size_t> typehashs;
+    std::vector<Entry> entries;
+    std::vector<const function*> metafunctions;
+    std::vector<const Entry*> table;
+    std::vector<std::uint32_t> displacements;
+    const function *constructor;
+    lua_CFunction destructorfn;
+    lua_CFunction indexfn;
+    lua_CFunction newindexfn;
+    int nslots;
+    bool hasproperties;
+    std::size_t index;
+    const char *type;
+#if defined (LUAWRAPPER_PROFILE)
+    Profiler::Class *profileclass;
+    // sorted by function
+    std::vector<std::pair<const function*, Profiler::Binding*>> bindings;
+#endif
+};
+
+template<typename T>
+void CreateMetatable (lua_State *L, bool destructor) noexcept {
+    CreateMetatable (L, ClassDescriptor::get<T> (), destructor);
+}
+
+} /* namespace detail */
+} /* namespace lua */
@@ -0,0 +1,120 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <array>
+#include <vector>
+
+namespace lua {
+namespace detail {
+
+template<typename... Ts>
+struct Columns {
+    // expects the row on top of the stack and the field names starting at stack index keys
+    template<int... S>
+    static bool pull (lua_State *L, int keys, std::vector<Ts> &...columns, seq<S...>) {
+        bool ok[] = { pull_field<Ts> (L, keys + S, columns)..., true };
+        for (bool b : ok) if (!b) return false;
+        return true;
+    }
+    template<int... S>
+    static void push (lua_State *L, int keys, std::size_t row, const std::vector<Ts> &...columns, seq<S...>) {
+        int dummy[] = { (push_field<Ts> (L, keys + S, columns[row]), 0)..., 0 };
+        (void) dummy;
+    }
+    template<typename T>
+    static bool pull_field (lua_State *L, int key, std::vector<T> &column) {
+        lua_pushvalue (L, key);
+        lua_rawget (L, -2);
+        bool ok = Type<T>::check (L, -1);
+        if (ok) column.push_back (Type<T>::pull (L, -1));
+        lua_pop (L, 1);
+        return ok;
+    }
+    // drops the elements appended since the columns had the given sizes
+    template<int... S>
+    static void truncate (const std::size_t *sizes, std::vector<Ts> &...columns, seq<S...>) {
+        int dummy[] = { (columns.erase (columns.begin () + sizes[S], columns.end ()), 0)..., 0 };
+        (void) dummy;
+    }
+    template<typename T>
+    static void push_field (lua_State *L, int key, const T &value) {
+        lua_pushvalue (L, key);
+        Type<T>::push (L, value);
+        lua_rawset (L, -3);
+    }
+};
+
+} /* namespace detail */
+
+// Appends the fields of an array of records to one column per field in a single pass,
+// e.g. pull_columns (L, -1, {{ "id", "x" }}, ids, xs). Fields are accessed raw.
+// Returns false if a row is not a table or a field has the wrong type, leaving the columns unchanged.
+template<typename... Ts>
+bool pull_columns (lua_State *L, const int &index, const std::array<const char*, sizeof... (Ts)> &fields,
+                   std::vector<Ts> &...columns)
+{
+    static_assert (sizeof... (Ts) > 0, "pull_columns needs at least one column.");
+    int table = detail::abs_index (L, index);
+    if (!lua_istable (L, table)) return false;
+    std::size_t n = lua_objlen (L, table);
+    const std::size_t sizes[] = { columns.size ()... };
+    int dummy[] = { (columns.reserve (columns.size () + n), 0)..., 0 };
+    (void) dummy;
+    // push the keys only once
+    int keys = lua_gettop (L) + 1;
+    for (const char *field : fields) lua_pushstring (L, field);
+    bool ok = true;
+    for (std::size_t i = 1; ok && i <= n; i++) {
+        lua_rawgeti (L, table, i);
+        ok = lua_istable (L, -1)
+             && detail::Columns<Ts...>::pull (L, keys, columns..., typename detail::gens<sizeof... (Ts)>::type ());
+        lua_pop (L, 1);
+    }
+    lua_settop (L, keys - 1);
+    if (!ok) detail::Columns<Ts...>::truncate (sizes, columns..., typename detail::gens<sizeof... (Ts)>::type ());
+    return ok;
+}
+
+// Pushes an array of records with one field per column; all columns must have the same size.
+template<typename... Ts>
+void push_columns (lua_State *L, const std::array<const char*, sizeof... (Ts)> &fields,
+                   const std::vector<Ts> &...columns)
+{
+    static_assert (sizeof... (Ts) > 0, "push_columns needs at least one column.");
+    std::size_t sizes[] = { columns.size ()... };
+    for (std::size_t size : sizes) {
+        if (size != sizes[0]) throw std::runtime_error ("Columns have different sizes.");
+    }
+    std::size_t n = sizes[0];
+    lua_createtable (L, n, 0);
+    int keys = lua_gettop (L) + 1;
+    for (const char *field : fields) lua_pushstring (L, field);
+    for (std::size_t i = 0; i < n; i++) {
+        lua_createtable (L, 0, sizeof... (Ts));
+        detail::Columns<Ts...>::push (L, keys, i, columns..., typename detail::gens<sizeof... (Ts)>::type ());
+        lua_rawseti (L, keys - 1, i + 1);
+    }
+    lua_settop (L, keys - 1);
+}
+
+} /* namespace lua */
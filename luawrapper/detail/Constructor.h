@@ -35,6 +35,9 @@ struct Constructor
             throw;
         }
         if (*ptr == nullptr) {
+#if defined (LUAWRAPPER_PROFILE)
+            Profiler::failed_check (L);
+#endif
             lua_pop (L, 1);
             results = 0;
             return false;
@@ -43,6 +46,7 @@ struct Constructor
         lua::detail::CreateMetatable<T> (L);
         lua_setmetatable (L, -3);
         lua_pop (L, 1);
+        lua::detail::CountCreated<T> (L);
         results = 1;
         return true;
     }
@@ -73,6 +77,9 @@ struct ConstructorWithSelfReference {
             throw;
         }
         if (*ptr == nullptr) {
+#if defined (LUAWRAPPER_PROFILE)
+            Profiler::failed_check (L);
+#endif
             lua_pop (L, 1);
             results = 0;
             return false;
@@ -81,6 +88,7 @@ struct ConstructorWithSelfReference {
         lua::detail::CreateMetatable<T> (L);
         lua_setmetatable(L, -3);
         lua_pop (L, 1);
+        lua::detail::CountCreated<T> (L);
         results = 1;
         return true;
     }
@@ -102,8 +110,29 @@ struct Destructor {
     static int Wrap (lua_State *L) noexcept {
         T *obj = static_cast<T*> (lua_touserdata (L, lua_upvalueindex (1)));
         delete obj;
+        detail::CountDestroyed<T> (L);
         return 0;
     }
 };
 
+// Destructor that leaves the actual destruction to State::drain_finalizers.
+// Falls back to immediate destruction for states not created by lua::State.
+template<typename T>
+struct DeferredDestructor {
+    static int Wrap (lua_State *L) noexcept {
+        T *obj = static_cast<T*> (lua_touserdata (L, lua_upvalueindex (1)));
+        detail::FinalizerQueue *queue = detail::GetFinalizerQueue (L);
+        if (queue == nullptr || !queue->push (obj, &Delete)) {
+            delete obj;
+        }
+        // counted when lua releases the object, the state may be gone once it is deleted
+        detail::CountDestroyed<T> (L);
+        return 0;
+    }
+private:
+    static void Delete (void *obj) {
+        delete static_cast<T*> (obj);
+    }
+};
+
 } /* namespace lua */
@@ -0,0 +1,105 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+namespace lua {
+
+// Lua thread anchored in the registry, running a function that may yield.
+class Coroutine {
+public:
+    Coroutine (void) : T (nullptr), started (false) {}
+    // creates a new thread that runs the function at the given index
+    Coroutine (lua_State *L, const int &index);
+    lua_State *thread (void) const { return T; }
+    // resumes with nargs arguments already pushed onto the thread and returns the
+    // lua_resume status, i.e. 0 when finished with the results on the thread's stack,
+    // LUA_YIELD or an error code with the message on top of the thread's stack
+    int resume_stack (int nargs);
+    template<typename... Args>
+    int resume (const Args &...args);
+    // also reflects resumes through Pending tokens
+    bool finished (void) const {
+        return T == nullptr || (started && lua_status (T) != LUA_YIELD);
+    }
+private:
+    lua_State *T;
+    Reference ref;
+    bool started;
+};
+
+// Return value of bound functions that suspends the calling coroutine until the
+// token is resumed, usually from a completion posted to a Scheduler. The token is
+// move-only: the binding moves it into the completion and returns an empty Pending,
+// so the thread anchor is never shared between threads. The thread stays anchored
+// until the token is resumed or destroyed, which must happen on the lua thread.
+class Pending {
+public:
+    Pending (void) : T (nullptr) {}
+    // throws if L is the main thread, which cannot yield
+    explicit Pending (lua_State *L);
+    Pending (Pending &&p) : T (p.T), ref (std::move (p.ref)) {
+        p.T = nullptr;
+    }
+    Pending (const Pending&) = delete;
+    Pending &operator= (Pending &&p) {
+        T = p.T; p.T = nullptr;
+        ref = std::move (p.ref);
+        return *this;
+    }
+    Pending &operator= (const Pending&) = delete;
+    lua_State *thread (void) const { return T; }
+    // resumes the suspended coroutine, passing the arguments as results of the bound call
+    // (resume_stack passes nargs values already pushed onto the thread);
+    // returns the lua_resume status like Coroutine::resume
+    int resume_stack (int nargs);
+    template<typename... Args>
+    int resume (const Args &...args);
+private:
+    lua_State *T;
+    Reference ref;
+};
+
+namespace detail {
+
+template<>
+struct is_pending<Pending> : std::true_type {};
+
+template<typename... Args>
+int PushAll (lua_State *L, const Args &...args) {
+    int dummy[] = { (Type<Args, void>::push (L, args), 0)..., 0 };
+    (void) dummy;
+    return sizeof... (Args);
+}
+
+} /* namespace detail */
+
+template<typename... Args>
+int Coroutine::resume (const Args &...args) {
+    return resume_stack (detail::PushAll (T, args...));
+}
+
+template<typename... Args>
+int Pending::resume (const Args &...args) {
+    return resume_stack (detail::PushAll (T, args...));
+}
+
+} /* namespace lua */
@@ -0,0 +1,124 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string>
+
+namespace lua {
+
+// Names of types in C declarations for the LuaJIT FFI.
+// Specialize for POD structs and add their declaration using FFIExport::declare.
+template<typename T, class = void>
+struct FFIType;
+
+template<>
+struct FFIType<void> {
+    static std::string name (void) { return "void"; }
+};
+
+template<>
+struct FFIType<bool> {
+    static std::string name (void) { return "bool"; }
+};
+
+template<>
+struct FFIType<char> {
+    static std::string name (void) { return "char"; }
+};
+
+template<typename T>
+struct FFIType<T, typename std::enable_if<!std::is_same<T, bool>::value && !std::is_same<T, char>::value
+                                          && std::is_integral<T>::value>::type> {
+    static std::string name (void) {
+        return (std::is_signed<T>::value ? "int" : "uint") + std::to_string (sizeof (T) * 8) + "_t";
+    }
+};
+
+template<>
+struct FFIType<float> {
+    static std::string name (void) { return "float"; }
+};
+
+template<>
+struct FFIType<double> {
+    static std::string name (void) { return "double"; }
+};
+
+template<typename T>
+struct FFIType<T*> {
+    static std::string name (void) {
+        return (std::is_const<T>::value ? "const " : "") + FFIType<typename std::remove_cv<T>::type>::name () + " *";
+    }
+};
+
+namespace detail {
+
+template<typename... Args>
+struct FFIArguments {
+    static std::string name (void) { return "void"; }
+};
+template<typename T>
+struct FFIArguments<T> {
+    static std::string name (void) { return FFIType<T>::name (); }
+};
+template<typename T, typename T1, typename... Args>
+struct FFIArguments<T, T1, Args...> {
+    static std::string name (void) { return FFIType<T>::name () + ", " + FFIArguments<T1, Args...>::name (); }
+};
+
+} /* namespace detail */
+
+// Exports functions with C compatible signatures to LuaJIT scripts as FFI function pointers.
+// Calls through those pointers are compiled by the JIT instead of aborting traces like lua_CFunctions.
+class FFIExport {
+public:
+    template<typename R, typename... Args>
+    FFIExport &add (const char *name, R (*fn) (Args...)) {
+        static_assert (std::is_void<R>::value || std::is_pod<R>::value, "FFI return values must be POD types.");
+        static_assert (detail::all_true<std::is_pod<Args>::value...>::value, "FFI arguments must be POD types.");
+        entries.push_back ({ name, FFIType<R>::name () + " (*) (" + detail::FFIArguments<Args...>::name () + ")",
+                             reinterpret_cast<void*> (fn) });
+        return *this;
+    }
+    // adds C declarations, e.g. of structs used in signatures
+    FFIExport &declare (const std::string &declaration) {
+        declarations += declaration;
+        declarations += "\n";
+        return *this;
+    }
+    // declarations passed to ffi.cdef
+    const std::string &cdef (void) const {
+        return declarations;
+    }
+    // creates a global table of FFI function pointers, requires LuaJIT's ffi module
+    void load (lua_State *L, const char *name) const;
+private:
+    struct Entry {
+        std::string name;
+        std::string type;
+        void *ptr;
+    };
+    std::vector<Entry> entries;
+    std::string declarations;
+};
+
+} /* namespace lua */
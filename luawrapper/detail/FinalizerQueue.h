@@ -0,0 +1,56 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <atomic>
+#include <cstddef>
+
+namespace lua {
+namespace detail {
+
+// Queue of objects whose destruction was deferred by DeferredDestructor.
+// Pushing is lock-free and may happen concurrently with a single thread draining the queue.
+class FinalizerQueue {
+public:
+    typedef void (*deleter) (void*);
+    FinalizerQueue (void) : head (nullptr), pending (nullptr) {}
+    FinalizerQueue (const FinalizerQueue&) = delete;
+    ~FinalizerQueue (void);
+    FinalizerQueue &operator= (const FinalizerQueue&) = delete;
+    bool push (void *obj, deleter fn) noexcept;
+    std::size_t drain (std::size_t budget);
+private:
+    struct Node {
+        void *obj;
+        deleter fn;
+        Node *next;
+    };
+    std::atomic<Node*> head;
+    // nodes already taken from head in queueing order, only touched by the draining thread
+    Node *pending;
+};
+
+FinalizerQueue *GetFinalizerQueue (lua_State *L);
+void SetFinalizerQueue (lua_State *L, FinalizerQueue *queue);
+
+} /* namespace detail */
+} /* namespace lua */
@@ -0,0 +1,106 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace lua {
+
+namespace detail {
+struct GCState;
+} /* namespace detail */
+
+// Collector control of a lua::State, see State::gc.
+class GC {
+public:
+    // pause and step multiplier settings: DEFAULT are lua's defaults, LOW_LATENCY does small
+    // automatic steps for states driven by step, LOW_MEMORY starts the next cycle right away
+    // and THROUGHPUT lets memory grow further between cycles
+    enum Preset { DEFAULT, LOW_LATENCY, LOW_MEMORY, THROUGHPUT };
+    struct Stats {
+        // bytes freed and in use after the call
+        std::size_t freed;
+        std::size_t inuse;
+        std::chrono::nanoseconds duration;
+        int steps;
+        // whether a collection cycle finished
+        bool cycle;
+    };
+    typedef std::function<void (const Stats&)> Callback;
+    // stops the collector while it exists; the collector restarts when the outermost
+    // Stop of the state ends
+    class Stop {
+    public:
+        explicit Stop (const GC &gc) : L (gc.L), state (gc.state) { GC (L, state).stop (); }
+        Stop (const Stop&) = delete;
+        ~Stop (void) { GC (L, state).restart (); }
+        Stop &operator= (const Stop&) = delete;
+    private:
+        lua_State *L;
+        detail::GCState *state;
+    };
+    GC (lua_State *L, detail::GCState *state) : L (L), state (state) {}
+    // runs incremental steps of stepsize kilobytes, or basic steps if 0, until a cycle
+    // finishes or the budget would be exceeded by another step as long as the longest so far;
+    // runs at least one step
+    Stats step (std::chrono::nanoseconds budget, int stepsize = 0);
+    // runs a full collection cycle
+    Stats collect (void);
+    void preset (Preset preset);
+    // set the pause and step multiplier and return the previous value
+    int pause (int value);
+    int stepmul (int value);
+    void stop (void);
+    void restart (void);
+    bool stopped (void) const;
+    // bytes in use, and bytes allocated and freed since the state was created if counted
+    std::size_t inuse (void) const;
+    std::size_t allocated (void) const;
+    std::size_t freed (void) const;
+    // called with the statistics of every step and collect
+    void on_stats (Callback callback);
+private:
+    template<typename F>
+    Stats run (F steps);
+    lua_State *L;
+    detail::GCState *state;
+};
+
+namespace detail {
+
+// Per state collector data; State allocates through Allocate, which keeps the byte counters.
+struct GCState {
+    std::size_t inuse;
+    std::size_t allocated;
+    std::size_t freed;
+    // whether the counters are fed by Allocate
+    bool counting;
+    int stopdepth;
+    GC::Callback callback;
+    static void *Allocate (void *ud, void *ptr, std::size_t osize, std::size_t nsize);
+};
+
+} /* namespace detail */
+
+} /* namespace lua */
@@ -0,0 +1,191 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <iterator>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace lua {
+
+// Return value that pushes a lua iterator function for use in generic for loops.
+// The iteration state lives in a userdata upvalue of the function and is destroyed
+// by the garbage collector, so loops may be left early.
+template<typename S>
+class Iteration {
+public:
+    explicit Iteration (S &&s) : state (std::move (s)) {}
+    void push (lua_State *L) &&;
+private:
+    S state;
+};
+
+namespace detail {
+
+template<typename T>
+struct IsPair : std::false_type {};
+
+template<typename K, typename V>
+struct IsPair<std::pair<K, V>> : std::true_type {};
+
+// pushes key and value for pairs and a running index and the value otherwise
+template<typename T, typename std::enable_if<IsPair<typename std::decay<T>::type>::value>::type* = nullptr>
+int PushIterated (lua_State *L, lua_Integer i, T &&v) {
+    Type<typename baretype<decltype (v.first)>::type>::push (L, v.first);
+    Type<typename baretype<decltype (v.second)>::type>::push (L, v.second);
+    return 2;
+}
+template<typename T, typename std::enable_if<!IsPair<typename std::decay<T>::type>::value>::type* = nullptr>
+int PushIterated (lua_State *L, lua_Integer i, T &&v) {
+    lua_pushinteger (L, i);
+    Type<typename baretype<T>::type>::push (L, std::forward<T> (v));
+    return 2;
+}
+
+// iterates over [begin, end) of a range that outlives the iteration
+template<typename It>
+struct RangeState {
+    RangeState (It begin, It end) : it (begin), last (end), i (0) {}
+    int next (lua_State *L) {
+        if (it == last) return 0;
+        return PushIterated (L, ++i, *it++);
+    }
+    It it, last;
+    lua_Integer i;
+};
+
+// iterates over a range owned by the iteration
+template<typename R>
+struct OwnedRangeState {
+    using iterator = decltype (std::begin (std::declval<R&> ()));
+    OwnedRangeState (R &&r) : range (std::move (r)), started (false), i (0) {}
+    int next (lua_State *L) {
+        // iterators are only taken once the range reached its final location
+        if (!started) {
+            it = std::begin (range);
+            last = std::end (range);
+            started = true;
+        }
+        if (it == last) return 0;
+        return PushIterated (L, ++i, *it++);
+    }
+    R range;
+    bool started;
+    iterator it, last;
+    lua_Integer i;
+};
+
+// calls fn (value) until it returns false, pushing one value per step
+template<typename T, typename F>
+struct GeneratorState {
+    GeneratorState (F &&f) : fn (std::move (f)) {}
+    int next (lua_State *L) {
+        T value;
+        if (!fn (value)) return 0;
+        Type<T>::push (L, std::move (value));
+        return 1;
+    }
+    F fn;
+};
+
+template<typename S>
+int IterationStep (lua_State *L) {
+    S *state = static_cast<S*> (lua_touserdata (L, lua_upvalueindex (1)));
+    try {
+        return state->next (L);
+    } catch (const std::exception &e) {
+        luaL_error (L, "Lua error: %s", e.what ());
+    } catch (...) {
+        luaL_error (L, "Lua error: unknown exception.");
+    }
+    return 0;
+}
+
+template<typename S>
+int IterationGC (lua_State *L) {
+    static_cast<S*> (lua_touserdata (L, 1))->~S ();
+    return 0;
+}
+
+} /* namespace detail */
+
+template<typename S>
+void Iteration<S>::push (lua_State *L) && {
+    void *ptr = lua_newuserdata (L, sizeof (S));
+    new (ptr) S (std::move (state));
+    // the metatable is shared by all iterations of the same type
+    static const char key = 0;
+    lua_pushlightuserdata (L, const_cast<char*> (&key));
+    lua_rawget (L, LUA_REGISTRYINDEX);
+    if (lua_isnil (L, -1)) {
+        lua_pop (L, 1);
+        lua_createtable (L, 0, 1);
+        lua_pushcfunction (L, detail::IterationGC<S>);
+        lua_setfield (L, -2, "__gc");
+        lua_pushlightuserdata (L, const_cast<char*> (&key));
+        lua_pushvalue (L, -2);
+        lua_rawset (L, LUA_REGISTRYINDEX);
+    }
+    lua_setmetatable (L, -2);
+    lua_pushcclosure (L, detail::IterationStep<S>, 1);
+}
+
+// return types of Iterate and Generate
+template<typename It>
+using RangeIteration = Iteration<detail::RangeState<It>>;
+template<typename R>
+using OwnedIteration = Iteration<detail::OwnedRangeState<R>>;
+template<typename T, typename F>
+using Generator = Iteration<detail::GeneratorState<T, F>>;
+
+// iterates over a range that must outlive the iteration
+template<typename It>
+RangeIteration<It> Iterate (It begin, It end) {
+    return RangeIteration<It> (detail::RangeState<It> (begin, end));
+}
+
+// iterates over a range, which is moved into the iteration if it is an rvalue
+template<typename R, typename std::enable_if<std::is_lvalue_reference<R>::value>::type* = nullptr>
+auto Iterate (R &&range) -> decltype (Iterate (std::begin (range), std::end (range))) {
+    return Iterate (std::begin (range), std::end (range));
+}
+template<typename R, typename std::enable_if<!std::is_lvalue_reference<R>::value>::type* = nullptr>
+OwnedIteration<R> Iterate (R &&range) {
+    return OwnedIteration<R> (detail::OwnedRangeState<R> (std::move (range)));
+}
+
+// generates values of type T by calling fn (T &value) until it returns false
+template<typename T, typename F>
+Generator<T, F> Generate (F fn) {
+    return Generator<T, F> (detail::GeneratorState<T, F> (std::move (fn)));
+}
+
+template<typename S>
+struct Type<Iteration<S>>
+{
+    static void push (lua_State *L, Iteration<S> &&v) {
+        std::move (v).push (L);
+    }
+};
+
+} /* namespace lua */
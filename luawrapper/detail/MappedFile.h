@@ -0,0 +1,60 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string>
+#include <vector>
+
+namespace lua {
+namespace detail {
+
+// Read-only memory mapping of a whole file; files are read into memory where mmap is unavailable.
+class MappedFile {
+public:
+    explicit MappedFile (const std::string &path);
+    MappedFile (const MappedFile&) = delete;
+    ~MappedFile (void);
+    MappedFile &operator= (const MappedFile&) = delete;
+    bool valid (void) const { return ok; }
+    const char *data (void) const { return ptr; }
+    std::size_t size (void) const { return len; }
+private:
+    const char *ptr;
+    std::size_t len;
+    bool ok;
+    std::vector<char> buffer;
+};
+
+// lua_Reader handing a whole buffer to lua_load without copying it
+struct BufferReader {
+    const char *data;
+    std::size_t size;
+    static const char *read (lua_State *L, void *ud, std::size_t *size) {
+        BufferReader *reader = static_cast<BufferReader*> (ud);
+        *size = reader->size;
+        reader->size = 0;
+        return *size > 0 ? reader->data : nullptr;
+    }
+};
+
+} /* namespace detail */
+} /* namespace lua */
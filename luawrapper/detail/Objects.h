@@ -0,0 +1,107 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace lua {
+
+struct ObjectCount {
+    std::string name;
+    std::size_t live;
+    std::size_t created;
+    // size of the live objects as far as known from their static type
+    std::size_t bytes;
+};
+
+namespace detail {
+
+// Counters of the objects owned by lua per class descriptor id, kept by push, the
+// constructors and the destructors. A state is used by one thread at a time, so the
+// counters are plain integers.
+class ObjectCounters {
+public:
+    struct Counter {
+        const char *type;
+        std::string name;
+        std::size_t live;
+        std::size_t created;
+        std::size_t bytes;
+    };
+    void created (const ClassDescriptor &descriptor, std::size_t size) {
+        Counter &counter = get (descriptor);
+        counter.live++;
+        counter.created++;
+        counter.bytes += size;
+    }
+    // the destructors keep a pointer to the counter of their class, which stays valid
+    // as long as the counters
+    static void destroyed (Counter &counter, std::size_t size) noexcept {
+        if (counter.live > 0) counter.live--;
+        counter.bytes = counter.bytes > size ? counter.bytes - size : 0;
+    }
+    Counter &get (const ClassDescriptor &descriptor) {
+        if (descriptor.id () >= counters.size ()) {
+            counters.resize (descriptor.id () + 1, Counter {nullptr, std::string (), 0, 0, 0});
+        }
+        Counter &counter = counters[descriptor.id ()];
+        if (counter.type == nullptr) counter.type = descriptor.type_name ();
+        return counter;
+    }
+    // the name the class was registered with in this state
+    void name (const ClassDescriptor &descriptor, const char *name);
+    std::vector<ObjectCount> counts (void) const;
+private:
+    // indexed by descriptor id; a deque keeps the counters in place when it grows
+    std::deque<Counter> counters;
+};
+
+ObjectCounters *GetObjectCounters (lua_State *L);
+void SetObjectCounters (lua_State *L, ObjectCounters *counters);
+
+template<typename T>
+void CountCreated (lua_State *L) {
+    ObjectCounters *counters = GetObjectCounters (L);
+    if (counters != nullptr) counters->created (ClassDescriptor::get<T> (), sizeof (T));
+}
+// expects to be called from a destructor closure created by ClassDescriptor::push_metatable
+template<typename T>
+void CountDestroyed (lua_State *L) noexcept {
+    void *counter = lua_touserdata (L, lua_upvalueindex (2));
+    if (counter != nullptr) ObjectCounters::destroyed (*static_cast<ObjectCounters::Counter*> (counter), sizeof (T));
+}
+
+} /* namespace detail */
+
+// Object counts of a lua::State for scripts, e.g. register_class (L, "objects", Objects::lua_functions)
+// for objects.counts (), which returns a table of { live, created, bytes } by class name.
+class Objects {
+public:
+    static std::vector<ObjectCount> counts (lua_State *L);
+    static int Counts (lua_State *L);
+    static functionlist lua_functions;
+};
+
+} /* namespace lua */
@@ -0,0 +1,90 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#if defined (LUAWRAPPER_PROFILE)
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lua {
+
+// Call statistics of bound functions, enabled by defining LUAWRAPPER_PROFILE for luawrapper
+// and everything using it. Functions pushed by a class descriptor are wrapped to count their
+// calls, the failed argument checks of their overloads and a log-linear latency histogram.
+// Recording uses relaxed atomics on one of SHARDS shards per binding, picked per thread.
+// Bindings are keyed by the function list of their class and named after the name the class
+// was first registered with, or its type name.
+class Profiler {
+public:
+    // histogram buckets have SUBBUCKETS subdivisions per power of two nanoseconds
+    static constexpr int SUBBITS = 2;
+    static constexpr int SUBBUCKETS = 1 << SUBBITS;
+    static constexpr int BUCKETS = 40 << SUBBITS;
+    static constexpr int SHARDS = 8;
+    struct Class;
+    struct Binding {
+        struct Shard {
+            std::atomic<std::uint64_t> calls;
+            std::atomic<std::uint64_t> failed;
+            std::atomic<std::uint64_t> histogram[BUCKETS];
+            // keeps the counters of different shards on different cache lines
+            char padding[64];
+        };
+        const Class *cls;
+        std::string name;
+        lua_CFunction func;
+        Shard shards[SHARDS];
+    };
+    struct Statistics {
+        std::string classname;
+        std::string name;
+        std::uint64_t calls;
+        std::uint64_t failed;
+        // completed calls per bucket
+        std::vector<std::uint64_t> histogram;
+        // upper bound in nanoseconds of the bucket containing the given fraction of the completed calls
+        std::uint64_t percentile (double fraction) const;
+    };
+    // lowest latency in nanoseconds counted in bucket
+    static std::uint64_t bucket_limit (int bucket);
+    static int bucket (std::uint64_t nanoseconds);
+    // statistics of all bindings that were called
+    static std::vector<Statistics> statistics (void);
+    static std::string json (void);
+    static std::string text (void);
+    static void reset (void);
+
+    // used by ClassDescriptor, register_class and the call helpers
+    static Class *get_class (const functionlist &functions, const char *type);
+    static Binding *binding (Class *cls, const function &fn, const char *name, lua_CFunction func);
+    static void name_class (Class *cls, const char *name);
+    // counts a failed argument check for the profiled binding running on L, if any
+    static void failed_check (lua_State *L);
+    // wrapper closure with upvalue 1 of the wrapped function and the binding as upvalue 2
+    static int Call (lua_State *L);
+};
+
+} /* namespace lua */
+#endif
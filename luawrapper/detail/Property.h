@@ -0,0 +1,76 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+namespace lua {
+namespace detail {
+
+template<typename C, typename T, T C::*M>
+struct PropertyAccess
+{
+    static int Get (lua_State *L) {
+        C *obj = static_cast<C*> (lua_touserdata (L, lua_upvalueindex (1)));
+        try {
+            Type<T>::push (L, obj->*M);
+        } catch (const std::exception &e) {
+            luaL_error (L, "Lua error: %s", e.what ());
+        } catch (...) {
+            luaL_error (L, "Lua error: unknown exception.");
+        }
+        return 1;
+    }
+    static int Set (lua_State *L) {
+        C *obj = static_cast<C*> (lua_touserdata (L, lua_upvalueindex (1)));
+        if (!Type<T>::check (L, -1)) luaL_error (L, "Invalid property value.");
+        try {
+            obj->*M = Type<T>::pull (L, -1);
+        } catch (const std::exception &e) {
+            luaL_error (L, "Lua error: %s", e.what ());
+        } catch (...) {
+            luaL_error (L, "Lua error: unknown exception.");
+        }
+        return 0;
+    }
+};
+
+} /* namespace detail */
+
+// Data member bindings, e.g. { "x", lua::Property<int>::Wrap<T, &T::x> }. The field type and
+// the class are spelled out, since C++11 cannot deduce them from a member pointer argument.
+template<typename T>
+struct Property {
+    template<typename C, T C::*M>
+    static detail::PropertyType<&detail::PropertyAccess<C, T, M>::Get, &detail::PropertyAccess<C, T, M>::Set>
+    Wrap (void) {
+        return {};
+    }
+    template<typename C, T C::*M>
+    static detail::PropertyType<&detail::PropertyAccess<C, T, M>::Get, nullptr> ReadOnly (void) {
+        return {};
+    }
+    template<typename C, T C::*M>
+    static detail::PropertyType<nullptr, &detail::PropertyAccess<C, T, M>::Set> WriteOnly (void) {
+        return {};
+    }
+};
+
+} /* namespace lua */
@@ -0,0 +1,108 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <istream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace lua {
+
+// Source of a chunk for State::load, handed to lua_load one block at a time. The readers
+// below throw std::runtime_error for a block size of 0.
+class Reader {
+public:
+    static constexpr std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+    virtual ~Reader (void) {}
+    // returns the next block of the chunk and its size, or a size of 0 at the end;
+    // exceptions abort loading with LUA_ERRFILE
+    virtual const char *read (std::size_t &size) = 0;
+protected:
+    // a block size of 0 would end the chunk on the first read
+    static std::size_t CheckBlockSize (std::size_t blocksize) {
+        if (blocksize == 0) throw std::runtime_error ("Block size must not be 0.");
+        return blocksize;
+    }
+};
+
+// Reads a file descriptor in blocks of the given size.
+class FileReader : public Reader {
+public:
+    explicit FileReader (const std::string &path, std::size_t blocksize = DEFAULT_BLOCK_SIZE);
+    // the file descriptor is not closed by the reader
+    explicit FileReader (int fd, std::size_t blocksize = DEFAULT_BLOCK_SIZE);
+    ~FileReader (void);
+    const char *read (std::size_t &size) override;
+private:
+    int fd;
+    bool owned;
+    std::vector<char> buffer;
+};
+
+// Maps a file into memory and hands it out in blocks of the given size without copying.
+class MappedReader : public Reader {
+public:
+    explicit MappedReader (const std::string &path, std::size_t blocksize = DEFAULT_BLOCK_SIZE);
+    const char *read (std::size_t &size) override;
+private:
+    detail::MappedFile file;
+    std::size_t offset;
+    std::size_t blocksize;
+};
+
+// Reads a std::istream in blocks of the given size.
+class StreamReader : public Reader {
+public:
+    explicit StreamReader (std::istream &stream, std::size_t blocksize = DEFAULT_BLOCK_SIZE)
+        : stream (stream), buffer (CheckBlockSize (blocksize)) {}
+    const char *read (std::size_t &size) override;
+private:
+    std::istream &stream;
+    std::vector<char> buffer;
+};
+
+// Copies the characters of an iterator range in blocks of the given size.
+template<typename It>
+class IteratorReader : public Reader {
+public:
+    IteratorReader (It begin, It end, std::size_t blocksize = DEFAULT_BLOCK_SIZE)
+        : it (begin), last (end), buffer (CheckBlockSize (blocksize)) {}
+    const char *read (std::size_t &size) override {
+        size = 0;
+        while (size < buffer.size () && it != last) {
+            buffer[size++] = *it++;
+        }
+        return buffer.data ();
+    }
+private:
+    It it, last;
+    std::vector<char> buffer;
+};
+
+template<typename It>
+IteratorReader<It> MakeReader (It begin, It end, std::size_t blocksize = Reader::DEFAULT_BLOCK_SIZE) {
+    return IteratorReader<It> (begin, end, blocksize);
+}
+
+} /* namespace lua */
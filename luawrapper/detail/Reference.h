@@ -21,6 +21,9 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <cstdint>
+#include <functional>
+
 namespace lua {
 
 class WeakReference;
@@ -28,20 +31,27 @@ class WeakReference;
 template<typename T, class>
 struct Type;
 
+// Reference to a lua value stored in the registry.
+// Copies share the registry slot, which is released when the last copy is destroyed.
+// Like the lua state itself, references must not be shared between threads.
 class Reference {
 public:
     Reference (lua_State *L, const int &index);
-    Reference (void) : L (nullptr), ref (LUA_NOREF), ptr (nullptr) {}
-    Reference (Reference &&r) : L (r.L), ref (r.ref), ptr (r.ptr) {
-        r.L = nullptr; r.ref = LUA_NOREF; r.ptr = nullptr;
+    Reference (void) : L (nullptr), handle (nullptr), ptr (nullptr) {}
+    Reference (Reference &&r) : L (r.L), handle (r.handle), ptr (r.ptr) {
+        r.L = nullptr; r.handle = nullptr; r.ptr = nullptr;
+    }
+    Reference (const Reference &r) : L (r.L), handle (r.handle), ptr (r.ptr) {
+        if (handle != nullptr) handle->count++;
     }
-    Reference (const Reference &r);
     explicit Reference (const WeakReference &r);
     Reference &operator= (const Reference &r);
     Reference &operator= (Reference &&r) noexcept;
-    ~Reference (void);
+    ~Reference (void) {
+        reset ();
+    }
     bool valid (void) const {
-        return L != nullptr && ref != LUA_NOREF && ref != LUA_REFNIL;
+        return handle != nullptr;
     }
     bool isnil (void) const;
     template<typename T, detail::if_not_pointer_t<T>* = nullptr>
@@ -52,17 +62,57 @@ public:
     bool checktype (void) const;
     template<typename T, detail::if_pointer_t<T>* = nullptr>
     bool checktype (void) const;
-    void reset (void);
+    void reset (void) {
+        if (handle != nullptr && --handle->count == 0) {
+            release ();
+        }
+        L = nullptr;
+        handle = nullptr;
+        ptr = nullptr;
+    }
     lua_State* const &GetLuaState (void) const { return L; }
     void push (void) const;
+    // pushes onto L, which must be a thread of the same state
+    void push (lua_State *L) const;
     bool operator< (const Reference &r) const;
     bool operator== (const Reference &r) const;
     bool operator!= (const Reference &r) const {
         return !operator== (r);
     }
+    // compares the identity of the values without touching the lua stack, i.e. like lua_rawequal
+    bool rawequal (const Reference &r) const {
+        return type () == r.type () && identity () == r.identity ();
+    }
+    // hash of the identity of the value, consistent with rawequal
+    std::size_t hash (void) const {
+        return std::hash<std::uint64_t> () (identity () ^ (std::uint64_t (type () + 1) << 56));
+    }
+    // lua type of the value as reported by lua_type when the reference was created
+    int type (void) const {
+        return handle != nullptr ? handle->type : LUA_TNIL;
+    }
+    struct RawEqual {
+        bool operator() (const Reference &a, const Reference &b) const {
+            return a.rawequal (b);
+        }
+    };
 private:
+    // registry slot shared by all copies
+    struct Handle {
+        int ref;
+        unsigned int count;
+        int type;
+        // pointer for tables, functions, userdata and threads, the interned
+        // string for strings and the value for numbers and booleans
+        std::uint64_t identity;
+    };
+    std::uint64_t identity (void) const {
+        return handle != nullptr ? handle->identity : 0;
+    }
+    void store (void);
+    void release (void);
     lua_State *L;
-    int ref;
+    Handle *handle;
     void **ptr;
     friend class WeakReference;
     template<typename T>
@@ -93,8 +143,8 @@ T Reference::convert (void) const {
 template<typename T, detail::if_not_pointer_t<T>*>
 bool Reference::checktype (void) const {
     // TODO: think about whether true is good for those values
-    if (L == nullptr || ref == LUA_NOREF || ref == LUA_REFNIL) return true;
-    lua_rawgeti (L, LUA_REGISTRYINDEX, ref);
+    if (handle == nullptr) return true;
+    lua_rawgeti (L, LUA_REGISTRYINDEX, handle->ref);
     bool result = Type<T, void>::check (L, -1);
     lua_pop (L, 1);
     return result;
@@ -102,8 +152,19 @@ bool Reference::checktype (void) const {
 
 template<typename T, detail::if_pointer_t<T>*>
 bool Reference::checktype (void) const {
-    if (ref == LUA_REFNIL || ref == LUA_NOREF) return true;
+    if (handle == nullptr) return true;
     return checktype<typename std::remove_pointer<T>::type> ();
 }
 
 } /* namespace lua */
+
+namespace std {
+
+template<>
+struct hash<lua::Reference> {
+    std::size_t operator() (const lua::Reference &r) const {
+        return r.hash ();
+    }
+};
+
+} /* namespace std */
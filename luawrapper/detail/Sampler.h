@@ -0,0 +1,98 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lua {
+
+namespace detail {
+// names of bound functions shown by Sampler, e.g. "Class.function"; register_class names
+// the functions of the class, the first name of a function is kept
+void NameFunction (lua_CFunction fn, const std::string &name);
+bool GetFunctionName (lua_CFunction fn, std::string &name);
+} /* namespace detail */
+
+// Samples the lua call stack of a state every interval instructions with a count hook and
+// aggregates the stacks into a call tree, which folded () prints in the folded stack format
+// of flame graph tools. The hook covers the thread it was started on and the coroutines
+// created after start. A count hook installed before start, e.g. by Budget, keeps being
+// called with the sampling interval, and stop restores the previous hook unless the hook
+// was replaced meanwhile. A Budget call started while sampling calls the sampler every
+// granularity instructions instead, and a budget that is exceeded ends the sampling.
+class Sampler {
+public:
+    explicit Sampler (lua_State *L, int interval = 1000, int maxdepth = 64);
+    Sampler (const Sampler&) = delete;
+    ~Sampler (void);
+    Sampler &operator= (const Sampler&) = delete;
+    void start (void);
+    void stop (void);
+    void clear (void);
+    std::uint64_t samples (void) const {
+        return count;
+    }
+    // one line per stack, outermost frame first: "frame;frame;frame count"
+    std::string folded (void) const;
+private:
+    struct Frame {
+        lua_CFunction cfunction;
+        // frames of lua functions are keyed by their source pointer, which may be reused
+        // once the function is collected, so the short source is compared as well
+        std::string source;
+        std::string name;
+    };
+    struct FrameHash {
+        std::size_t operator() (const std::pair<std::uintptr_t, int> &key) const {
+            return std::hash<std::uintptr_t> () (key.first) ^ (std::hash<int> () (key.second) * 31);
+        }
+    };
+    struct Node {
+        std::uint32_t parent;
+        std::uint32_t frame;
+        std::uint64_t count;
+    };
+    static void hook (lua_State *L, lua_Debug *ar);
+    void sample (lua_State *T);
+    std::uint32_t intern (lua_State *T, lua_Debug &ar);
+    lua_State *L;
+    int interval;
+    int maxdepth;
+    bool running;
+    lua_Hook prevhook;
+    int prevmask, prevcount;
+    void *prevsampler;
+    // set while the previous hook runs, which may lead back to this hook
+    bool chaining;
+    std::uint64_t count;
+    std::vector<Frame> frames;
+    std::unordered_map<std::pair<std::uintptr_t, int>, std::uint32_t, FrameHash> frameindex;
+    // node 0 is the root of the call tree
+    std::vector<Node> nodes;
+    std::unordered_map<std::uint64_t, std::uint32_t> children;
+    std::vector<std::uint32_t> stack;
+};
+
+} /* namespace lua */
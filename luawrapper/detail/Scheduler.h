@@ -0,0 +1,90 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#if defined (_WIN32)
+#include <condition_variable>
+#endif
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace lua {
+
+// Queue of completions of asynchronous work that resume suspended coroutines on the
+// thread running the lua state. post may be called from any thread; the file descriptor
+// becomes readable whenever completions are queued, so it can be added to an epoll set.
+class Scheduler {
+public:
+    // a posted completion; unlike std::function it takes move-only callables, e.g. ones
+    // owning a Pending token
+    class Completion {
+    public:
+        template<typename F, typename std::enable_if<!std::is_same<typename std::decay<F>::type,
+                                                                   Completion>::value>::type* = nullptr>
+        Completion (F &&fn) : impl (new Impl<typename std::decay<F>::type> (std::forward<F> (fn))) {}
+        void operator() (void) {
+            impl->call ();
+        }
+    private:
+        struct Base {
+            virtual ~Base (void) {}
+            virtual void call (void) = 0;
+        };
+        template<typename F>
+        struct Impl : Base {
+            template<typename G>
+            explicit Impl (G &&g) : fn (std::forward<G> (g)) {}
+            void call (void) override {
+                fn ();
+            }
+            F fn;
+        };
+        std::unique_ptr<Base> impl;
+    };
+    Scheduler (void);
+    Scheduler (const Scheduler&) = delete;
+    ~Scheduler (void);
+    Scheduler &operator= (const Scheduler&) = delete;
+    void post (Completion fn);
+    // runs the queued completions and returns the number run; if a completion throws,
+    // the completions after it stay queued and the exception is rethrown
+    std::size_t run (void);
+    // waits at most timeout milliseconds (or forever if negative) for completions
+    bool wait (int timeout);
+    // -1 on platforms without eventfd or pipes
+    int fd (void) const { return fds[0]; }
+private:
+    void signal (void);
+    void clear (void);
+    std::mutex mutex;
+    std::vector<Completion> queue;
+    int fds[2];
+#if defined (_WIN32)
+    // wakes wait in place of the file descriptor
+    std::condition_variable ready;
+#endif
+};
+
+} /* namespace lua */
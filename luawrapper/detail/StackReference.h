@@ -0,0 +1,74 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+namespace lua {
+
+// Reference to a value on the lua stack that is only valid as long as its stack slot,
+// e.g. for the duration of a call to a bound function. Unlike Reference it does not
+// store the value in the registry; use promote to keep the value beyond that.
+class StackReference {
+public:
+    StackReference (void) : L (nullptr), index (0) {}
+    StackReference (lua_State *L_, const int &index_) : L (L_), index (detail::abs_index (L_, index_)) {}
+    bool valid (void) const {
+        return L != nullptr;
+    }
+    bool isnil (void) const {
+        return L == nullptr || lua_isnil (L, index);
+    }
+    template<typename T>
+    decltype(Type<T, void>::pull (nullptr, 0)) convert (void) const {
+        return Type<T, void>::pull (L, index);
+    }
+    template<typename T>
+    bool checktype (void) const {
+        return L != nullptr && Type<T, void>::check (L, index);
+    }
+    void push (void) const {
+        if (L != nullptr) lua_pushvalue (L, index);
+    }
+    Reference promote (void) const {
+        return L != nullptr ? Reference (L, index) : Reference ();
+    }
+    lua_State* const &GetLuaState (void) const { return L; }
+    const int &GetIndex (void) const { return index; }
+protected:
+    lua_State *L;
+    int index;
+};
+
+// Stack reference to a value that was checked to have type T.
+template<typename T>
+class ArgRef : public StackReference {
+public:
+    ArgRef (void) : StackReference () {}
+    ArgRef (lua_State *L_, const int &index_) : StackReference (L_, index_) {}
+    decltype(Type<T, void>::pull (nullptr, 0)) get (void) const {
+        return convert<T> ();
+    }
+    TypedReference<T> promote (void) const {
+        return L != nullptr ? TypedReference<T> (L, index) : TypedReference<T> ();
+    }
+};
+
+} /* namespace lua */
@@ -21,8 +21,21 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <memory>
+#include <cstdint>
+
 namespace lua {
 
+class Reader;
+class GC;
+struct ObjectCount;
+
+namespace detail {
+class TimerWheel;
+struct GCState;
+class ObjectCounters;
+} /* namespace detail */
+
 class State {
 public:
     State (void);
@@ -35,12 +48,36 @@ public:
         return L;
     }
     void loadlib (const lua_CFunction &fn, const std::string &name);
+    // runs at most budget destructors deferred by DeferredDestructor and returns the number run;
+    // may be called from another thread, but only from one thread at a time
+    std::size_t drain_finalizers (std::size_t budget = std::numeric_limits<std::size_t>::max ());
+    // advances the timers of Timers to now (in milliseconds) and resumes or calls everything
+    // that is due; returns the number of timers fired
+    std::size_t run_timers (std::uint64_t now);
+    // collector control; memory is counted by the allocator of the state where the lua
+    // implementation allows custom allocators
+    GC gc (void);
+    // live and created objects owned by the state per class, named after the class name
+    // registered in this state or the type name
+    std::vector<ObjectCount> objects (void) const;
+    // loads a lua file like luaL_loadfile, but stores the compiled chunk in cachedir, keyed by
+    // the lua version, path and source, and maps the cached bytecode on later calls; cachedir
+    // must exist, otherwise the source is compiled on every call
+    int load_cached (const std::string &path, const std::string &cachedir);
+    // loads a chunk block by block like lua_load, without holding a copy of the whole source;
+    // returns the lua_load status with the function or the error message on the stack
+    int load (Reader &reader, const std::string &chunkname);
+    // compiles all .lua files below dir into the cache of load_cached on several threads,
+    // each with a temporary state, and returns the number of cache files written; cachedir must exist
+    static std::size_t precompile (const std::string &dir, const std::string &cachedir, unsigned int threads = 0);
 private:
-    static void push_weak_registry (lua_State *L);
     lua_State *L;
-    friend class WeakReference;
-    template<typename, class>
-    friend struct Type;
+    std::unique_ptr<detail::FinalizerQueue> finalizers;
+    std::unique_ptr<detail::TimerWheel> timers;
+    // used by the allocator until lua_close
+    std::unique_ptr<detail::GCState> gcstate;
+    // finalizers run by lua_close still count
+    std::unique_ptr<detail::ObjectCounters> objectcounters;
 };
 
 } /* namespace lua */
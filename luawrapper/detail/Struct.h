@@ -0,0 +1,158 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <utility>
+#include <type_traits>
+
+namespace lua {
+namespace detail {
+
+// Fields of structs that declare
+//     template<typename V> static void lua_fields (V &v) { v ("x", &T::x); ... }
+// are converted from and to lua tables by the Type specialization below.
+template<typename T>
+struct HasFields {
+private:
+    struct Visitor {
+        template<typename F>
+        void operator() (const char *name, F T::*member) {}
+    };
+    template<typename U>
+    static std::true_type test (decltype (U::template lua_fields<Visitor> (std::declval<Visitor&> ()))*);
+    template<typename U>
+    static std::false_type test (...);
+public:
+    static constexpr bool value = decltype (test<T> (nullptr))::value;
+};
+
+template<typename T>
+struct StructFields {
+    static int count (void) {
+        static const int n = [] {
+            Counter counter { 0 };
+            T::lua_fields (counter);
+            return counter.n;
+        } ();
+        return n;
+    }
+    // pushes a sequence of the field names, created once per lua state and cached in the registry
+    static void push_keys (lua_State *L) {
+        static const char key = 0;
+        lua_pushlightuserdata (L, const_cast<char*> (&key));
+        lua_rawget (L, LUA_REGISTRYINDEX);
+        if (lua_isnil (L, -1)) {
+            lua_pop (L, 1);
+            lua_createtable (L, count (), 0);
+            Namer namer { L, 0 };
+            T::lua_fields (namer);
+            lua_pushlightuserdata (L, const_cast<char*> (&key));
+            lua_pushvalue (L, -2);
+            lua_rawset (L, LUA_REGISTRYINDEX);
+        }
+    }
+    struct Counter {
+        template<typename F>
+        void operator() (const char *name, F T::*member) {
+            n++;
+        }
+        int n;
+    };
+    struct Namer {
+        template<typename F>
+        void operator() (const char *name, F T::*member) {
+            lua_pushstring (L, name);
+            lua_rawseti (L, -2, ++i);
+        }
+        lua_State *L;
+        int i;
+    };
+    // expects the keys below the new table on the stack
+    struct Pusher {
+        template<typename F>
+        void operator() (const char *name, F T::*member) {
+            lua_rawgeti (L, -2, ++i);
+            Type<F>::push (L, v.*member);
+            lua_rawset (L, -3);
+        }
+        lua_State *L;
+        const T &v;
+        int i;
+    };
+    // checks and optionally pulls each field in one pass, stopping at the first mismatch
+    struct Puller {
+        template<typename F>
+        void operator() (const char *name, F T::*member) {
+            if (!ok) return;
+            lua_rawgeti (L, keys, ++i);
+            lua_rawget (L, table);
+            if (check) ok = Type<F>::check (L, -1);
+            if (ok && v != nullptr) v->*member = Type<F>::pull (L, -1);
+            lua_pop (L, 1);
+        }
+        lua_State *L;
+        int table;
+        int keys;
+        int i;
+        T *v;
+        bool check;
+        bool ok;
+    };
+    static bool pull (lua_State *L, const int &index, T *v, bool check) {
+        int table = abs_index (L, index);
+        if (check && !lua_istable (L, table)) return false;
+        push_keys (L);
+        Puller puller { L, table, lua_gettop (L), 0, v, check, true };
+        T::lua_fields (puller);
+        lua_pop (L, 1);
+        return puller.ok;
+    }
+};
+
+} /* namespace detail */
+
+// Fields are accessed raw, i.e. without invoking metamethods.
+template<typename T>
+struct Type<T, typename std::enable_if<detail::HasFields<T>::value>::type>
+{
+    static bool check (lua_State *L, const int &index) {
+        return detail::StructFields<T>::pull (L, index, nullptr, true);
+    }
+    static T pull (lua_State *L, const int &index) {
+        T v;
+        detail::StructFields<T>::pull (L, index, &v, false);
+        return v;
+    }
+    // checks and pulls in a single pass, leaving v partially assigned on failure
+    static bool try_pull (lua_State *L, const int &index, T &v) {
+        return detail::StructFields<T>::pull (L, index, &v, true);
+    }
+    static void push (lua_State *L, const T &v) {
+        detail::StructFields<T>::push_keys (L);
+        lua_createtable (L, 0, detail::StructFields<T>::count ());
+        typename detail::StructFields<T>::Pusher pusher { L, v, 0 };
+        T::lua_fields (pusher);
+        lua_remove (L, -2);
+    }
+};
+
+} /* namespace lua */
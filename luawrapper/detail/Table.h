@@ -0,0 +1,191 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace lua {
+
+// String key interned once and cached in the registry, so that table lookups
+// neither hash nor copy the name again.
+class Key {
+public:
+    Key (void) {}
+    Key (lua_State *L, const char *name);
+    Key (lua_State *L, const std::string &name);
+    void push (void) const {
+        ref.push ();
+    }
+    // pushes onto L, which may be any thread of the state the key was created on
+    void push (lua_State *L) const {
+        ref.push (L);
+    }
+    lua_State* const &GetLuaState (void) const { return ref.GetLuaState (); }
+private:
+    Reference ref;
+};
+
+namespace detail {
+
+inline void PushKey (lua_State *L, const Key &key) {
+    key.push (L);
+}
+inline void PushKey (lua_State *L, const char *key) {
+    lua_pushstring (L, key);
+}
+inline void PushKey (lua_State *L, const std::string &key) {
+    lua_pushlstring (L, key.data (), key.size ());
+}
+template<typename K>
+void PushKey (lua_State *L, const K &key) {
+    Type<K>::push (L, key);
+}
+
+} /* namespace detail */
+
+// View of a lua table that either lives on the stack or is stored in the registry.
+class Table {
+public:
+    Table (void) : L (nullptr), index (0) {}
+    // stack backed table, only valid as long as its stack slot
+    Table (lua_State *L_, const int &index_) : L (L_), index (detail::abs_index (L_, index_)) {}
+    // registry backed table
+    explicit Table (const Reference &r) : L (r.GetLuaState ()), index (0), ref (r) {}
+    // creates a new registry backed table
+    static Table create (lua_State *L, int narr = 0, int nrec = 0);
+    bool valid (void) const {
+        return L != nullptr;
+    }
+    void push (void) const;
+    // length of the array part as reported by the # operator
+    std::size_t size (void) const;
+    // throws if the value does not have type T
+    template<typename T, typename K>
+    T get (const K &key) const;
+    // fetches several fields at once and throws if any of them has the wrong type
+    template<typename... Ts, typename... Ks>
+    std::tuple<Ts...> get_many (const Ks &...keys) const;
+    template<typename K, typename V>
+    void set (const K &key, const V &value);
+    // calls fn (key, value) for every entry whose key and value have the types K and V
+    template<typename K, typename V, typename F>
+    void foreach (F &&fn) const;
+    lua_State* const &GetLuaState (void) const { return L; }
+    Reference reference (void) const;
+private:
+    // table index on the stack, pushing registry backed tables; throws if the value is
+    // not a table, since indexing it would raise a lua error outside a protected call
+    struct StackHelper {
+        StackHelper (const Table *table) : L (table->L), pushed (table->index == 0) {
+            if (pushed) table->ref.push ();
+            index = pushed ? lua_gettop (L) : table->index;
+            if (!lua_istable (L, index)) {
+                if (pushed) lua_pop (L, 1);
+                throw Exception (L, 1, "lua value is not a table.");
+            }
+        }
+        ~StackHelper (void) {
+            if (pushed) lua_pop (L, 1);
+        }
+        lua_State *L;
+        bool pushed;
+        int index;
+    };
+    template<typename T, typename K>
+    T field (const int &t, const K &key) const;
+    lua_State *L;
+    int index;
+    Reference ref;
+};
+
+template<typename T, typename K>
+T Table::field (const int &t, const K &key) const {
+    detail::PushKey (L, key);
+    lua_gettable (L, t);
+    if (!Type<T>::check (L, -1)) {
+        lua_pop (L, 1);
+        throw Exception (L, 1, "lua value has invalid type.");
+    }
+    struct PopHelper {
+        ~PopHelper (void) { lua_pop (L, 1); }
+        lua_State *L;
+    } pophelper { L };
+    return Type<T>::pull (L, -1);
+}
+
+template<typename T, typename K>
+T Table::get (const K &key) const {
+    StackHelper stackhelper (this);
+    return field<T> (stackhelper.index, key);
+}
+
+template<typename... Ts, typename... Ks>
+std::tuple<Ts...> Table::get_many (const Ks &...keys) const {
+    static_assert (sizeof... (Ts) == sizeof... (Ks), "get_many needs one key per type.");
+    StackHelper stackhelper (this);
+    // braced initialization evaluates the fields in order
+    return std::tuple<Ts...> { field<Ts> (stackhelper.index, keys)... };
+}
+
+template<typename K, typename V>
+void Table::set (const K &key, const V &value) {
+    StackHelper stackhelper (this);
+    detail::PushKey (L, key);
+    Type<V>::push (L, value);
+    lua_settable (L, stackhelper.index);
+}
+
+template<typename K, typename V, typename F>
+void Table::foreach (F &&fn) const {
+    StackHelper stackhelper (this);
+    struct IterationHelper {
+        ~IterationHelper (void) { lua_settop (L, top); }
+        lua_State *L;
+        int top;
+    } iterationhelper { L, lua_gettop (L) };
+    lua_pushnil (L);
+    while (lua_next (L, stackhelper.index)) {
+        // pull the key from a copy, since converting it in place would confuse lua_next
+        lua_pushvalue (L, -2);
+        if (Type<K>::check (L, -1) && Type<V>::check (L, -2)) {
+            fn (Type<K>::pull (L, -1), Type<V>::pull (L, -2));
+        }
+        lua_pop (L, 2);
+    }
+}
+
+template<>
+struct Type<Table>
+{
+    static bool check (lua_State *L, const int &index) { return lua_istable (L, index); }
+    static Table pull (lua_State *L, const int &index) {
+        return Table (L, index);
+    }
+    static void push (lua_State *L, const Table &t) {
+        t.push ();
+        if (t.GetLuaState () != L) lua_xmove (t.GetLuaState (), L, 1);
+    }
+};
+
+} /* namespace lua */
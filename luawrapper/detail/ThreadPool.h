@@ -0,0 +1,58 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <vector>
+
+namespace lua {
+
+// Pool of lua threads for running many short coroutines. All threads are anchored in a
+// single registry table; finished threads are kept on a free list and handed out again
+// with an empty stack, so acquiring and releasing threads is O(1).
+class ThreadPool {
+public:
+    struct Thread {
+        lua_State *L;
+        int slot;
+        operator lua_State* (void) const { return L; }
+    };
+    explicit ThreadPool (lua_State *L);
+    ThreadPool (const ThreadPool&) = delete;
+    ~ThreadPool (void);
+    ThreadPool &operator= (const ThreadPool&) = delete;
+    // if env is true, the thread gets a fresh globals table for the request, falling back
+    // to the globals of the state for reads; chunks loaded on the thread use it as environment
+    Thread acquire (bool env = false);
+    // threads that did not finish, i.e. that are suspended or failed, are not reused
+    void release (const Thread &thread);
+    // number of threads created and number of threads on the free list
+    std::size_t size (void) const { return count; }
+    std::size_t available (void) const { return free.size (); }
+private:
+    lua_State *L;
+    int table;
+    int envmeta;
+    std::size_t count;
+    std::vector<int> free;
+};
+
+} /* namespace lua */
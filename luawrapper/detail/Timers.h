@@ -0,0 +1,90 @@
+/*
+ * C++ helper and wrapper functions for Lua.
+ *
+ * Copyright (c) 2015 Daniel Kirchner
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <cstdint>
+#include <string>
+
+namespace lua {
+namespace detail {
+
+// Hierarchical timer wheel with LEVELS levels of SLOTS slots each. A timer is kept at the
+// level of the highest digit in which its due time differs from the current time and
+// cascades to lower levels as time advances, so insertion and expiry are O(1) amortized.
+// Per level bitmaps of occupied slots let run skip idle periods.
+class TimerWheel {
+public:
+    explicit TimerWheel (lua_State *L);
+    TimerWheel (const TimerWheel&) = delete;
+    ~TimerWheel (void);
+    TimerWheel &operator= (const TimerWheel&) = delete;
+    std::uint64_t now (void) const { return current; }
+    std::size_t size (void) const { return count; }
+    // resumes the suspended coroutine after delay ticks
+    void resume (std::uint64_t delay, Pending &&pending);
+    // calls fn on a new coroutine after delay ticks and then every period ticks, if
+    // period is not 0, until it returns false
+    void call (std::uint64_t delay, std::uint64_t period, Reference &&fn);
+    // advances to now and fires all timers due until then; returns the number fired and
+    // throws once all are fired if any of them raised an error
+    std::size_t run (std::uint64_t now);
+private:
+    static constexpr int BITS = 6;
+    static constexpr int SLOTS = 1 << BITS;
+    static constexpr int LEVELS = 4;
+    struct Timer {
+        std::uint64_t due;
+        std::uint64_t period;
+        Pending pending;
+        Reference fn;
+        Timer *next;
+    };
+    void insert (Timer *timer);
+    void cascade (int level);
+    bool fire (Timer *timer, std::string &error);
+    std::uint64_t next_event (void) const;
+    lua_State *L;
+    Timer *wheel[LEVELS][SLOTS];
+    std::uint64_t occupied[LEVELS];
+    Timer *overflow;
+    std::uint64_t current;
+    std::size_t count;
+};
+
+TimerWheel *GetTimerWheel (lua_State *L);
+void SetTimerWheel (lua_State *L, TimerWheel *wheel);
+
+} /* namespace detail */
+
+// Timer functions for scripts of a lua::State, e.g. register_class (L, "timer", Timers::lua_functions)
+// for timer.sleep (ms), timer.after (ms, fn) and timer.every (ms, fn).
+class Timers {
+public:
+    // suspends the calling coroutine
+    static Pending sleep (lua_State *L, lua_Integer ms);
+    static void after (lua_State *L, lua_Integer ms, StackReference fn);
+    // fn is called until it returns false
+    static void every (lua_State *L, lua_Integer ms, StackReference fn);
+    static functionlist lua_functions;
+};
+
+} /* namespace lua */
@@ -25,6 +25,16 @@
 #include <deque>
 #include <map>
 #include <unordered_map>
+#include <set>
+#include <unordered_set>
+#include <array>
+#include <tuple>
+#include <cstring>
+#if __cplusplus >= 201703L
+#include <string_view>
+#include <optional>
+#include <variant>
+#endif
 
 namespace lua {
 
@@ -116,6 +126,62 @@ struct Type<std::string>
     static void push (lua_State *L, const std::string &v) { lua_pushlstring (L, v.data (), v.length ()); }
 };
 
+// View of a lua string, only valid as long as the string is on the stack,
+// e.g. for the duration of a call to a bound function.
+struct StringView {
+    const char *data;
+    std::size_t size;
+    std::string str (void) const {
+        return std::string (data, size);
+    }
+    bool operator== (const StringView &v) const {
+        return size == v.size && !std::memcmp (data, v.data, size);
+    }
+    bool operator!= (const StringView &v) const {
+        return !operator== (v);
+    }
+};
+
+template<>
+struct Type<StringView>
+{
+    static bool check (lua_State *L, const int &index) { return lua_isstring (L, index); }
+    static StringView pull (lua_State *L, const int &index) {
+        StringView v { nullptr, 0 };
+        v.data = lua_tolstring (L, index, &v.size);
+        return v;
+    }
+    static void push (lua_State *L, const StringView &v) { lua_pushlstring (L, v.data, v.size); }
+};
+
+template<>
+struct Type<const char*>
+{
+    static bool check (lua_State *L, const int &index) { return lua_isstring (L, index); }
+    static const char *pull (lua_State *L, const int &index) { return lua_tostring (L, index); }
+    static void push (lua_State *L, const char *v) {
+        if (v != nullptr) {
+            lua_pushstring (L, v);
+        } else {
+            lua_pushnil (L);
+        }
+    }
+};
+
+#if __cplusplus >= 201703L
+template<>
+struct Type<std::string_view>
+{
+    static bool check (lua_State *L, const int &index) { return lua_isstring (L, index); }
+    static std::string_view pull (lua_State *L, const int &index) {
+        std::size_t len = 0;
+        const char *str = lua_tolstring (L, index, &len);
+        return std::string_view (str, len);
+    }
+    static void push (lua_State *L, std::string_view v) { lua_pushlstring (L, v.data (), v.size ()); }
+};
+#endif
+
 template<>
 struct Type<ManualReturn>
 {
@@ -130,19 +196,23 @@ struct Type<Reference>
         return Reference (L, index);
     }
     static void push (lua_State *L, const Reference &t) {
-        lua_rawgeti (L, LUA_REGISTRYINDEX, t.ref);
+        if (t.handle != nullptr) {
+            lua_rawgeti (L, LUA_REGISTRYINDEX, t.handle->ref);
+        } else {
+            lua_pushnil (L);
+        }
     }
 };
 
 template<typename T>
 struct Type<TypedReference<T>>
 {
-    static bool check (lua_State *L, const int &index) { return true; }
+    static bool check (lua_State *L, const int &index) { return Type<T>::check (L, index); }
     static TypedReference<T> pull (lua_State *L, const int &index) {
         return TypedReference<T> (L, index);
     }
     static void push (lua_State *L, const TypedReference<T> &t) {
-        lua_rawgeti (L, LUA_REGISTRYINDEX, t.ref);
+        Type<Reference>::push (L, t);
     }
 };
 
@@ -154,6 +224,50 @@ struct Type<WeakReference>
     static void push (lua_State *L, const WeakReference &v);
 };
 
+template<>
+struct Type<StackReference>
+{
+    static bool check (lua_State *L, const int &index) { return true; }
+    static StackReference pull (lua_State *L, const int &index) {
+        return StackReference (L, index);
+    }
+    static void push (lua_State *L, const StackReference &v) {
+        if (v.GetLuaState () == L) {
+            lua_pushvalue (L, v.GetIndex ());
+        } else if (v.valid ()) {
+            v.push ();
+            lua_xmove (v.GetLuaState (), L, 1);
+        } else {
+            lua_pushnil (L);
+        }
+    }
+};
+
+template<typename T>
+struct Type<ArgRef<T>>
+{
+    static bool check (lua_State *L, const int &index) { return Type<T>::check (L, index); }
+    static ArgRef<T> pull (lua_State *L, const int &index) {
+        return ArgRef<T> (L, index);
+    }
+    static void push (lua_State *L, const ArgRef<T> &v) {
+        Type<StackReference>::push (L, v);
+    }
+};
+
+namespace detail {
+
+// reserves storage in containers that support it
+template<typename C>
+auto Reserve (C &c, std::size_t n, int) -> decltype (c.reserve (n), void ()) {
+    c.reserve (n);
+}
+template<typename C>
+void Reserve (C &c, std::size_t n, long) {
+}
+
+} /* namespace detail */
+
 template<typename T>
 struct IsSequence {
     static constexpr bool value = false;
@@ -177,9 +291,11 @@ struct IsSequence<std::deque<T, A>> {
 template<typename C>
 struct Type<C, typename std::enable_if<IsSequence<C>::value>::type>
 {
-    static bool check (lua_State *L, const int &index) {
+    static bool check (lua_State *L, const int &_index) {
+        int index = detail::abs_index (L, _index);
         if (!lua_istable (L, index)) return false;
-        for (auto i = 1; i <= lua_objlen (L, index); i++) {
+        int n = lua_objlen (L, index);
+        for (auto i = 1; i <= n; i++) {
             lua_rawgeti (L, index, i);
             if (!Type<typename C::value_type>::check (L, -1)) {
                 lua_pop (L, 1);
@@ -189,9 +305,12 @@ struct Type<C, typename std::enable_if<IsSequence<C>::value>::type>
         }
         return true;
     }
-    static C pull (lua_State *L, const int &index) {
+    static C pull (lua_State *L, const int &_index) {
+        int index = detail::abs_index (L, _index);
+        int n = lua_objlen (L, index);
         C v;
-        for (auto i = 1; i <= lua_objlen (L, index); i++) {
+        detail::Reserve (v, n, 0);
+        for (auto i = 1; i <= n; i++) {
             lua_rawgeti (L, index, i);
             v.emplace_back (Type<typename C::value_type>::pull (L, -1));
             lua_pop (L, 1);
@@ -199,7 +318,7 @@ struct Type<C, typename std::enable_if<IsSequence<C>::value>::type>
         return v;
     }
     static void push (lua_State *L, const C &v) {
-        lua_newtable (L);
+        lua_createtable (L, v.size (), 0);
         auto i = 1;
         auto it = v.begin ();
         while (it != v.end ()) {
@@ -209,18 +328,54 @@ struct Type<C, typename std::enable_if<IsSequence<C>::value>::type>
     }
 };
 
+// fixed size arrays require a lua sequence of exactly the same length
+template<typename T, std::size_t N>
+struct Type<std::array<T, N>>
+{
+    static bool check (lua_State *L, const int &_index) {
+        int index = detail::abs_index (L, _index);
+        if (!lua_istable (L, index) || lua_objlen (L, index) != N) return false;
+        for (std::size_t i = 1; i <= N; i++) {
+            lua_rawgeti (L, index, i);
+            if (!Type<T>::check (L, -1)) {
+                lua_pop (L, 1);
+                return false;
+            }
+            lua_pop (L, 1);
+        }
+        return true;
+    }
+    static std::array<T, N> pull (lua_State *L, const int &_index) {
+        int index = detail::abs_index (L, _index);
+        std::array<T, N> v;
+        for (std::size_t i = 1; i <= N; i++) {
+            lua_rawgeti (L, index, i);
+            v[i - 1] = Type<T>::pull (L, -1);
+            lua_pop (L, 1);
+        }
+        return v;
+    }
+    static void push (lua_State *L, const std::array<T, N> &v) {
+        lua_createtable (L, N, 0);
+        for (std::size_t i = 0; i < N; i++) {
+            Type<T>::push (L, v[i]);
+            lua_rawseti (L, -2, i + 1);
+        }
+    }
+};
+
 template<typename T>
 struct IsMap {
     static constexpr bool value = false;
 };
 
-template<typename K, typename T, typename A>
-struct IsMap<std::unordered_map<K, T, A>> {
+template<typename K, typename T, typename H, typename E, typename A>
+struct IsMap<std::unordered_map<K, T, H, E, A>> {
     static constexpr bool value = true;
 };
 
-template<typename K, typename T, typename A>
-struct IsMap<std::map<K, T, A>> {
+template<typename K, typename T, typename C, typename A>
+struct IsMap<std::map<K, T, C, A>> {
     static constexpr bool value = true;
 };
 
@@ -249,19 +404,241 @@ public:
         C v;
         lua_pushnil (L);
         while (lua_next (L, index) != 0) {
-            v.emplace (Type<K>::pull (L, -2), Type<T>::pull (L, -1));
-            lua_pop (L, 1);
+            // pull the key from a copy, since converting it in place would confuse lua_next
+            lua_pushvalue (L, -2);
+            v.emplace (Type<K>::pull (L, -1), Type<T>::pull (L, -2));
+            lua_pop (L, 2);
         }
         return v;
     }
     static void push (lua_State *L, const C &v) {
-        lua_newtable (L);
+        lua_createtable (L, 0, v.size ());
         for (auto it = v.begin (); it != v.end (); it++) {
-            Type<K>::push (L, it.first);
-            Type<T>::push (L, it.second);
+            Type<K>::push (L, it->first);
+            Type<T>::push (L, it->second);
             lua_rawset (L, -3);
         }
     }
 };
 
+template<typename T>
+struct IsSet {
+    static constexpr bool value = false;
+};
+
+template<typename K, typename H, typename E, typename A>
+struct IsSet<std::unordered_set<K, H, E, A>> {
+    static constexpr bool value = true;
+};
+
+template<typename K, typename C, typename A>
+struct IsSet<std::set<K, C, A>> {
+    static constexpr bool value = true;
+};
+
+// sets are tables mapping their elements to true
+template<typename C>
+struct Type<C, typename std::enable_if<IsSet<C>::value>::type>
+{
+private:
+    using K = typename C::key_type;
+public:
+    static bool check (lua_State *L, const int &_index) {
+        int index = detail::abs_index (L, _index);
+        if (!lua_istable (L, index)) return false;
+        lua_pushnil (L);
+        while (lua_next (L, index) != 0) {
+            if (!Type<K>::check (L, -2) || !lua_isboolean (L, -1)) {
+                lua_pop (L, 2);
+                return false;
+            }
+            lua_pop (L, 1);
+        }
+        return true;
+    }
+    static C pull (lua_State *L, const int &_index) {
+        int index = detail::abs_index (L, _index);
+        C v;
+        lua_pushnil (L);
+        while (lua_next (L, index) != 0) {
+            if (lua_toboolean (L, -1)) {
+                lua_pushvalue (L, -2);
+                v.emplace (Type<K>::pull (L, -1));
+                lua_pop (L, 1);
+            }
+            lua_pop (L, 1);
+        }
+        return v;
+    }
+    static void push (lua_State *L, const C &v) {
+        lua_createtable (L, 0, v.size ());
+        for (const K &k : v) {
+            Type<K>::push (L, k);
+            lua_pushboolean (L, 1);
+            lua_rawset (L, -3);
+        }
+    }
+};
+
+// pairs and tuples are small sequences with one element per member
+template<typename... Ts>
+struct Type<std::tuple<Ts...>>
+{
+private:
+    template<int... S>
+    static bool check_elements (lua_State *L, int index, detail::seq<S...>) {
+        bool ok[] = { check_element<Ts> (L, index, S + 1)..., true };
+        for (bool b : ok) if (!b) return false;
+        return true;
+    }
+    template<typename T>
+    static bool check_element (lua_State *L, int index, int i) {
+        lua_rawgeti (L, index, i);
+        bool ok = Type<T>::check (L, -1);
+        lua_pop (L, 1);
+        return ok;
+    }
+    template<typename T>
+    static T pull_element (lua_State *L, int index, int i) {
+        lua_rawgeti (L, index, i);
+        struct PopHelper {
+            ~PopHelper (void) { lua_pop (L, 1); }
+            lua_State *L;
+        } pophelper { L };
+        return Type<T>::pull (L, -1);
+    }
+    template<typename T>
+    static int push_element (lua_State *L, const T &v, int i) {
+        Type<T>::push (L, v);
+        lua_rawseti (L, -2, i);
+        return 0;
+    }
+    template<int... S>
+    static std::tuple<Ts...> pull_elements (lua_State *L, int index, detail::seq<S...>) {
+        // braced initialization evaluates the elements in order
+        return std::tuple<Ts...> { pull_element<Ts> (L, index, S + 1)... };
+    }
+    template<int... S>
+    static void push_elements (lua_State *L, const std::tuple<Ts...> &v, detail::seq<S...>) {
+        int dummy[] = { push_element<Ts> (L, std::get<S> (v), S + 1)..., 0 };
+        (void) dummy;
+    }
+public:
+    static bool check (lua_State *L, const int &_index) {
+        int index = detail::abs_index (L, _index);
+        return lua_istable (L, index) && check_elements (L, index, typename detail::gens<sizeof... (Ts)>::type ());
+    }
+    static std::tuple<Ts...> pull (lua_State *L, const int &_index) {
+        return pull_elements (L, detail::abs_index (L, _index), typename detail::gens<sizeof... (Ts)>::type ());
+    }
+    static void push (lua_State *L, const std::tuple<Ts...> &v) {
+        lua_createtable (L, sizeof... (Ts), 0);
+        push_elements (L, v, typename detail::gens<sizeof... (Ts)>::type ());
+    }
+};
+
+template<typename T1, typename T2>
+struct Type<std::pair<T1, T2>>
+{
+    static bool check (lua_State *L, const int &index) {
+        return Type<std::tuple<T1, T2>>::check (L, index);
+    }
+    static std::pair<T1, T2> pull (lua_State *L, const int &index) {
+        std::tuple<T1, T2> t = Type<std::tuple<T1, T2>>::pull (L, index);
+        return std::pair<T1, T2> (std::move (std::get<0> (t)), std::move (std::get<1> (t)));
+    }
+    static void push (lua_State *L, const std::pair<T1, T2> &v) {
+        lua_createtable (L, 2, 0);
+        Type<T1>::push (L, v.first);
+        lua_rawseti (L, -2, 1);
+        Type<T2>::push (L, v.second);
+        lua_rawseti (L, -2, 2);
+    }
+};
+
+#if __cplusplus >= 201703L
+template<typename T>
+struct Type<std::optional<T>>
+{
+    static bool check (lua_State *L, const int &index) {
+        return lua_isnil (L, index) || Type<T>::check (L, index);
+    }
+    static std::optional<T> pull (lua_State *L, const int &index) {
+        if (lua_isnil (L, index)) return std::nullopt;
+        return std::optional<T> (Type<T>::pull (L, index));
+    }
+    static void push (lua_State *L, const std::optional<T> &v) {
+        if (v) {
+            Type<T>::push (L, *v);
+        } else {
+            lua_pushnil (L);
+        }
+    }
+};
+
+namespace detail {
+
+// mask of the lua types (1 << lua_type) a type may be pulled from, used to dispatch variants
+template<typename T, class = void>
+struct LuaTypeMask : std::integral_constant<unsigned int, ~0u> {};
+
+template<typename T>
+struct LuaTypeMask<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+        : std::integral_constant<unsigned int, 1u << LUA_TNUMBER> {};
+
+template<>
+struct LuaTypeMask<bool> : std::integral_constant<unsigned int, 1u << LUA_TBOOLEAN> {};
+
+template<typename T>
+struct LuaTypeMask<T, std::enable_if_t<std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>
+                                       || std::is_same_v<T, StringView> || std::is_same_v<T, const char*>>>
+        : std::integral_constant<unsigned int, 1u << LUA_TSTRING> {};
+
+template<typename T>
+struct LuaTypeMask<T, std::enable_if_t<IsSequence<T>::value || IsMap<T>::value || IsSet<T>::value>>
+        : std::integral_constant<unsigned int, 1u << LUA_TTABLE> {};
+
+} /* namespace detail */
+
+// Pulls the first alternative whose lua type matches, falling back to the first
+// alternative that accepts the value, e.g. a numeric string for an integer.
+template<typename... Ts>
+struct Type<std::variant<Ts...>>
+{
+private:
+    using V = std::variant<Ts...>;
+    template<std::size_t I>
+    static int find (lua_State *L, const int &index, unsigned int type) {
+        if constexpr (I == sizeof... (Ts)) {
+            return -1;
+        } else {
+            using T = std::variant_alternative_t<I, V>;
+            if ((detail::LuaTypeMask<T>::value & type) && Type<T>::check (L, index)) return I;
+            return find<I + 1> (L, index, type);
+        }
+    }
+    static int find (lua_State *L, const int &index) {
+        int i = find<0> (L, index, 1u << lua_type (L, index));
+        return i >= 0 ? i : find<0> (L, index, ~0u);
+    }
+    template<std::size_t I>
+    static V pull (lua_State *L, const int &index, int i) {
+        if constexpr (I + 1 < sizeof... (Ts)) {
+            if (i != int (I)) return pull<I + 1> (L, index, i);
+        }
+        return V (std::in_place_index<I>, Type<std::variant_alternative_t<I, V>>::pull (L, index));
+    }
+public:
+    static bool check (lua_State *L, const int &index) {
+        return find (L, index) >= 0;
+    }
+    static V pull (lua_State *L, const int &index) {
+        return pull<0> (L, index, find (L, index));
+    }
+    static void push (lua_State *L, const V &v) {
+        std::visit ([L] (const auto &x) { Type<std::decay_t<decltype (x)>>::push (L, x); }, v);
+    }
+};
+#endif
+
 } /* namespace lua */
@@ -32,12 +32,12 @@ public:
     }
     TypedReference (void) : Reference () {
     }
-    TypedReference (TypedReference<T> &&r) : Reference (r) {
+    TypedReference (TypedReference<T> &&r) : Reference (std::move (r)) {
     }
     TypedReference (const TypedReference<T> &r) : Reference (r) {
     }
-    TypedReference (Reference &&r) : Reference (r) {
-        if (r.ref != LUA_REFNIL && !checktype<T> ()) throw Exception (L, 1, "lua value has invalid type.");
+    TypedReference (Reference &&r) : Reference (std::move (r)) {
+        if (!checktype<T> ()) throw Exception (L, 1, "lua value has invalid type.");
     }
     TypedReference (const Reference &r) : Reference (r) {
         if (!checktype<T> ()) throw Exception (L, 1, "lua value has invalid type.");
@@ -58,7 +58,7 @@ public:
     }
     TypedReference<T> &operator= (Reference &&r) {
         if (!r.checktype<T> ()) throw Exception (L, 1, "lua value has invalid type.");
-        Reference::operator= (r);
+        Reference::operator= (std::move (r));
         return *this;
     }
     TypedReference<T> &operator= (const TypedReference<T> &r) {
@@ -66,7 +66,7 @@ public:
         return *this;
     }
     TypedReference<T> &operator= (TypedReference<T> &&r) noexcept {
-        Reference::operator= (r);
+        Reference::operator= (std::move (r));
         return *this;
     }
 };
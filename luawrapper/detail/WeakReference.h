@@ -21,14 +21,40 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <cstddef>
+
 namespace lua {
+namespace detail {
+
+// Weak table holding the values of weak references of a lua state, created on first use.
+struct WeakTable {
+    // key of a value only referenced by the weak table, cleared by every garbage collection
+    static constexpr int SENTINEL = -1;
+    int ref;
+    unsigned int generation;
+    // expects the weak table on top of the stack
+    void update (lua_State *L) {
+        lua_rawgeti (L, -1, SENTINEL);
+        bool collected = lua_isnil (L, -1);
+        lua_pop (L, 1);
+        if (collected) {
+            generation++;
+            lua_newtable (L);
+            lua_rawseti (L, -2, SENTINEL);
+        }
+    }
+};
+
+WeakTable *GetWeakTable (lua_State *L);
+
+} /* namespace detail */
 
 class WeakReference {
 public:
-    WeakReference (void) : L (nullptr), ref (LUA_NOREF) {}
+    WeakReference (void) : L (nullptr), ref (LUA_NOREF), table (nullptr), validgeneration (0) {}
     WeakReference (lua_State *L, const int &index);
-    WeakReference (WeakReference &&r) : L (r.L), ref (r.ref) {
-        r.L = nullptr; r.ref = LUA_NOREF;
+    WeakReference (WeakReference &&r) : L (r.L), ref (r.ref), table (r.table), validgeneration (r.validgeneration) {
+        r.L = nullptr; r.ref = LUA_NOREF; r.table = nullptr;
     }
     WeakReference (const WeakReference &r);
     WeakReference (const Reference &r);
@@ -37,6 +63,11 @@ public:
     WeakReference &operator= (const Reference &r);
     ~WeakReference (void);
     bool valid (void) const;
+    // checks the validity of several weak references fetching each weak table only once
+    // and returns the number of valid references
+    static std::size_t valid (const WeakReference *refs, std::size_t count, bool *results);
+    // counter that changes whenever a garbage collection may have invalidated weak references of the state
+    static unsigned int generation (lua_State *L);
     operator const int &(void) const { return ref; }
     template<typename T>
     decltype(Type<T, void>::pull (nullptr, 0)) convert (void) const;
@@ -45,9 +76,15 @@ public:
     void reset (void);
     lua_State* const &GetLuaState (void) const { return L; }
     void push (void) const;
+    // pushes onto L, which must be a thread of the same state
+    void push (lua_State *L) const;
 private:
+    void assign (lua_State *L, const int &index);
     lua_State *L;
     int ref;
+    detail::WeakTable *table;
+    // generation of the weak table in which the value was last found to be valid
+    mutable unsigned int validgeneration;
     friend class Reference;
     template<typename, class>
     friend struct Type;
@@ -56,12 +93,11 @@ private:
 template<typename T>
 inline decltype(Type<T, void>::pull (nullptr, 0)) WeakReference::convert (void) const {
     struct StackHelper {
-        StackHelper (const WeakReference *ref) : L (ref->GetLuaState ()){
-            State::push_weak_registry (L);
-            lua_rawgeti (L, -1, ref->ref);
+        StackHelper (const WeakReference *ref) : L (ref->GetLuaState ()) {
+            ref->push ();
         }
         ~StackHelper (void) {
-            lua_pop (L, 2);
+            lua_pop (L, 1);
         }
         lua_State *L;
     } stackhelper (this);
@@ -71,12 +107,11 @@ inline decltype(Type<T, void>::pull (nullptr, 0)) WeakReference::convert (void)
 template<typename T>
 bool WeakReference::checktype (void) const {
     if (L == nullptr || ref == LUA_NOREF || ref == LUA_REFNIL) return false;
-    State::push_weak_registry (L);
+    lua_rawgeti (L, LUA_REGISTRYINDEX, table->ref);
     lua_rawgeti (L, -1, ref);
     bool result = Type<T, void>::check (L, -1);
     lua_pop (L, 2);
     return result;
 }
 
-
 } /* namespace lua */
@@ -39,6 +39,8 @@ struct IndexfunctionType {};
 struct NewindexfunctionType {};
 template<typename T>
 struct BaseClassType {};
+template<lua_CFunction Getter, lua_CFunction Setter>
+struct PropertyType {};
 
 } /* namespace detail */
 
@@ -70,11 +72,13 @@ public:
             : type (INDEXFUNCTION), name (nullptr), func (_func) { }
     function (const lua_CFunction &_func, detail::NewindexfunctionType)
             : type (METAFUNCTION), name ("__newindex"), func (_func) { }
+    template<lua_CFunction Getter, lua_CFunction Setter>
+    function (const char *_name, detail::PropertyType<Getter, Setter> (*) (void))
+            : type (PROPERTY), name (_name), func (Getter), setfunc (Setter) { }
     template<typename T>
     function (detail::BaseClassType<T> (*func) (void)) : type (BASECLASS), listptr (&Functions<T>::value),
                                                          hashcode (typeid (T).hash_code ()) { }
-    friend void detail::AddToStaticTables (lua_State *L, const function *ptr, const size_t &size) noexcept;
-    friend void detail::AddToTables (lua_State *L, const function *ptr, const size_t &size, std::vector<size_t> &typehashs, bool destructor) noexcept;
+    friend class detail::ClassDescriptor;
 private:
     enum Type {
         MEMBERFUNCTION,
@@ -83,13 +87,16 @@ private:
         BASECLASS,
         CONSTRUCTOR,
         DESTRUCTOR,
-        INDEXFUNCTION
+        INDEXFUNCTION,
+        PROPERTY
     };
     enum Type type;
     union {
         struct {
             const char *name;
             lua_CFunction func;
+            // only used for properties, func is the getter in that case
+            lua_CFunction setfunc;
         };
         struct {
             const functionlist *listptr;
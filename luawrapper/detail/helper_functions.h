@@ -29,14 +29,14 @@ template<typename T>
 struct Functions;
 
 namespace detail {
-void AddToTables (lua_State *L, const function *ptr, const size_t &size, std::vector<size_t> &typehashs, bool destructor = true) noexcept;
-void AddToStaticTables (lua_State *L, const function *ptr, const size_t &size) noexcept;
+class ClassDescriptor;
 bool CheckType (lua_State *L, const int &index, const size_t &typehash);
-void CreateMetatable (lua_State *L, const functionlist &functions, const size_t &typehash, bool destructor = true) noexcept;
+void CreateMetatable (lua_State *L, const ClassDescriptor &descriptor, bool destructor = true) noexcept;
 template<typename T>
-void CreateMetatable (lua_State *L, bool destructor = true) noexcept {
-    CreateMetatable (L, Functions<T>::value, typeid (T).hash_code (), destructor);
-}
+void CreateMetatable (lua_State *L, bool destructor = true) noexcept;
+// pointers stored in the registry under the address of a static variable
+void *GetRegistryPointer (lua_State *L, const void *key);
+void SetRegistryPointer (lua_State *L, const void *key, void *ptr);
 inline int abs_index (lua_State *L, const int &index) {
     return index > 0 || index <= LUA_REGISTRYINDEX ? index : lua_gettop (L) + index + 1;
 }
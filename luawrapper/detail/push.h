@@ -25,34 +25,37 @@ namespace lua {
 
 template<typename T>
 T *push (detail::if_not_pointer_t<T, lua_State> *L, T &&t) {
-    T **obj = static_cast<T**> (lua_newuserdata (L, sizeof (T)));
+    T **obj = static_cast<T**> (lua_newuserdata (L, sizeof (T*)));
     *obj = new T (std::move (t));
     lua_pushlightuserdata (L, *obj);
     detail::CreateMetatable<T> (L);
     lua_setmetatable (L, -3);
     lua_pop (L, 1);
+    detail::CountCreated<T> (L);
     return *obj;
 }
 
 template<typename T, typename... Args>
 T *push (detail::if_not_pointer_t<T, lua_State> *L, Args... args) {
-    T **obj = static_cast<T**> (lua_newuserdata (L, sizeof (T)));
+    T **obj = static_cast<T**> (lua_newuserdata (L, sizeof (T*)));
     *obj = new T (args...);
     lua_pushlightuserdata (L, *obj);
     detail::CreateMetatable<T> (L);
     lua_setmetatable (L, -3);
     lua_pop (L, 1);
+    detail::CountCreated<T> (L);
     return *obj;
 }
 
 template<typename T>
 T *push (detail::if_not_pointer_t<T, lua_State> *L, const T &t) {
-    T **obj = static_cast<T**> (lua_newuserdata (L, sizeof (T)));
+    T **obj = static_cast<T**> (lua_newuserdata (L, sizeof (T*)));
     *obj = new T (t);
     lua_pushlightuserdata (L, *obj);
     detail::CreateMetatable<T> (L);
     lua_setmetatable (L, -3);
     lua_pop (L, 1);
+    detail::CountCreated<T> (L);
     return *obj;
 }
 
@@ -64,6 +67,7 @@ T push (detail::if_pointer_t<T, lua_State> *L, const T &t) {
     detail::CreateMetatable<typename std::remove_pointer<T>::type> (L);
     lua_setmetatable (L, -3);
     lua_pop (L, 1);
+    detail::CountCreated<typename std::remove_pointer<T>::type> (L);
     return *obj;
 }
 
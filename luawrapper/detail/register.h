@@ -24,9 +24,10 @@
 namespace lua {
 
 void register_class (lua_State *L, const char *name, const functionlist &functions);
+void register_class (lua_State *L, const char *name, const detail::ClassDescriptor &descriptor);
 template<typename T>
 void register_class (lua_State *L, const char *name) {
-    register_class (L, name, Functions<T>::value);
+    register_class (L, name, detail::ClassDescriptor::get<T> ());
 }
 
 } /* namespace lua */
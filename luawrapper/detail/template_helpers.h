@@ -37,6 +37,8 @@ template <int N, typename U0, typename... U> struct tuple_element<N, U0, U...> {
 };
 inline bool alltrue (void) { return true; }
 template<typename... Args> bool alltrue (bool u, Args... args) { return u && alltrue (args...); }
+template<bool...> struct all_true : std::true_type {};
+template<bool B, bool... Bs> struct all_true<B, Bs...> : std::integral_constant<bool, B && all_true<Bs...>::value> {};
 
 template<typename... Args>
 struct count_tuple_elements;
@@ -49,10 +51,17 @@ struct count_tuple_elements<T, T0, Args...>
         : std::integral_constant<int, count_tuple_elements<T, Args...>::value
                                       + (std::is_same<T, T0>::value ? 1 : 0)> {};
 
+// return types of bound functions that yield the calling coroutine instead of returning values
+template<typename R>
+struct is_pending : std::false_type {};
+
 template<typename R, typename T>
 using if_void_t = typename std::enable_if<std::is_same<R, void>::value, T>::type;
 template<typename R, typename T>
-using if_not_void_t = typename std::enable_if<!std::is_same<R, void>::value, T>::type;
+using if_not_void_t = typename std::enable_if<!std::is_same<R, void>::value
+                                              && !is_pending<typename baretype<R>::type>::value, T>::type;
+template<typename R, typename T>
+using if_pending_t = typename std::enable_if<is_pending<typename baretype<R>::type>::value, T>::type;
 
 template<typename R, typename T = void>
 using if_pointer_t = typename std::enable_if<std::is_pointer<R>::value, T>::type;
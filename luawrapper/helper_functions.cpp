@@ -26,152 +26,60 @@
 namespace lua {
 namespace detail {
 
-void AddToTables (lua_State *L, const function *ptr, const size_t &size, std::vector<size_t> &typehashs, bool destructor) noexcept
+bool CheckType (lua_State *L, const int &index, const size_t &typehash)
 {
-    for (auto i = 0; i < size; i++) {
-        switch (ptr[i].type) {
-            case function::MEMBERFUNCTION:
-                // push upvalue
-                lua_pushvalue (L, -3);
-                // push closure
-                lua_pushcclosure (L, ptr[i].func, 1);
-                // add to index table
-                lua_setfield (L, -2, ptr[i].name);
-                break;
-            case function::STATICFUNCTION:
-                // push function
-                lua_pushcfunction (L, ptr[i].func);
-                // add to index table
-                lua_setfield (L, -2, ptr[i].name);
-                break;
-            case function::METAFUNCTION:
-                // push upvalue
-                lua_pushvalue (L, -3);
-                // push closure
-                lua_pushcclosure (L, ptr[i].func, 1);
-                // add to meta table
-                lua_setfield (L, -3, ptr[i].name);
-                break;
-            case function::DESTRUCTOR:
-                if (destructor) {
-                    // push upvalue
-                    lua_pushvalue (L, -3);
-                    // push closure
-                    lua_pushcclosure (L, ptr[i].func, 1);
-                    // add to meta table
-                    lua_setfield (L, -3, "__gc");
-                }
-                break;
-            case function::BASECLASS:
-                typehashs.push_back (ptr[i].hashcode);
-                AddToTables (L, ptr[i].listptr->begin (), ptr[i].listptr->size (), typehashs, false);
-                break;
-            case function::INDEXFUNCTION:
-                // create new metatable
-                lua_newtable (L);
-                // push upvalue
-                lua_pushvalue (L, -4);
-                // push closure
-                lua_pushcclosure (L, ptr[i].func, 1);
-                // add to new metatable
-                lua_setfield (L, -2, "__index");
-                // set metatable of index table
-                lua_setmetatable (L, -2);
-                break;
-            default:
-                break;
-        }
-    }
+    if (!lua_getmetatable (L, index)) return false;
+    lua_getfield (L, -1, "__ctypes");
+    const ClassDescriptor *descriptor = static_cast<const ClassDescriptor*> (lua_touserdata (L, -1));
+    lua_pop (L, 2);
+    return descriptor != nullptr && descriptor->derives (typehash);
 }
 
-bool CheckType (lua_State *L, const int &index, const size_t &typehash)
+void *GetRegistryPointer (lua_State *L, const void *key)
 {
-    static_assert (sizeof (lua_Number) >= sizeof (size_t), "lua_Number is smaller than size_t");
-    lua_getmetatable (L, index);
-    if (lua_isnil (L, -1)) return false;
-    lua_getfield (L, -1, "__ctypes");
-    if (lua_isnil (L, -1)) return false;
-    int i = 1;
-    while (true) {
-        lua_rawgeti (L, -1, i++);
-        if (lua_isnil (L, -1)) {
-            lua_pop (L, 3);
-            return false;
-        }
-        lua_Number v = lua_tonumber (L, -1);
-        if (*reinterpret_cast<size_t*> (&v) == typehash) {
-            lua_pop (L, 3);
-            return true;
-        }
-        lua_pop (L, 1);
-    }
+    lua_pushlightuserdata (L, const_cast<void*> (key));
+    lua_rawget (L, LUA_REGISTRYINDEX);
+    void *ptr = lua_touserdata (L, -1);
+    lua_pop (L, 1);
+    return ptr;
 }
 
-void AddToStaticTables (lua_State *L, const function *ptr, const size_t &size) noexcept
+void SetRegistryPointer (lua_State *L, const void *key, void *ptr)
 {
-    for (auto i = 0; i < size; i++) {
-        switch (ptr[i].type) {
-            case function::STATICFUNCTION:
-                // register function
-                lua_pushcfunction (L, ptr[i].func);
-                lua_setfield (L, -3, ptr[i].name);
-                break;
-            case function::CONSTRUCTOR:
-                // register constructors
-                lua_pushcfunction (L, ptr[i].func);
-                lua_setfield (L, -2, "__call");
-                break;
-            default:
-                break;
-        }
+    lua_pushlightuserdata (L, const_cast<void*> (key));
+    if (ptr != nullptr) {
+        lua_pushlightuserdata (L, ptr);
+    } else {
+        lua_pushnil (L);
     }
+    lua_rawset (L, LUA_REGISTRYINDEX);
 }
 
-void CreateMetatable (lua_State *L, const functionlist &functions, const size_t &typehash, bool destructor) noexcept
+void CreateMetatable (lua_State *L, const ClassDescriptor &descriptor, bool destructor) noexcept
 {
-    static_assert (sizeof (lua_Number) >= sizeof (size_t), "lua_Number is smaller than size_t");
-
-    std::vector<size_t> typehashs;
-    typehashs.push_back (typehash);
-    // create metatable
-    lua_newtable (L);
-
-    // create index table
-    lua_newtable (L);
-
-    // populate index table
-    AddToTables (L, functions.begin (), functions.size (), typehashs, destructor);
-
-    // register index table
-    lua_setfield (L, -2, "__index");
-
-    // create type table
-    lua_newtable (L);
-    for (auto i = 0; i < typehashs.size (); i++) {
-        lua_Number n = 0;
-        *reinterpret_cast<size_t*> (&n) = typehashs[i];
-        lua_pushnumber (L, n);
-        lua_rawseti (L, -2, i + 1);
-    }
-    lua_setfield (L, -2, "__ctypes");
+    descriptor.push_metatable (L, destructor);
 }
 } /* namespace detail */
 
-void register_class (lua_State *L, const char *name, const functionlist &functions)
+void register_class (lua_State *L, const char *name, const detail::ClassDescriptor &descriptor)
 {
-    // create table
-    lua_newtable (L);
-
-    // create metatable
-    lua_newtable (L);
-
-    detail::AddToStaticTables (L, functions.begin (), functions.size ());
-
-    // set metatable
-    lua_setmetatable (L, -2);
+#if defined (LUAWRAPPER_PROFILE)
+    Profiler::name_class (descriptor.profile (), name);
+#endif
+    descriptor.name_functions (name);
+    if (detail::ObjectCounters *counters = detail::GetObjectCounters (L)) {
+        counters->name (descriptor, name);
+    }
+    // create class table
+    descriptor.push_class (L);
 
     // set global
     lua_setfield (L, LUA_GLOBALSINDEX, name);
 }
 
+void register_class (lua_State *L, const char *name, const functionlist &functions)
+{
+    register_class (L, name, detail::ClassDescriptor (functions, 0));
+}
+
 } /* namespace lua */
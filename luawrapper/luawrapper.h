@@ -45,21 +45,41 @@ extern "C" {
 #include "detail/Exception.h"
 #include "detail/template_helpers.h"
 #include "detail/helper_functions.h"
+#include "detail/FinalizerQueue.h"
 #include "detail/State.h"
 #include "detail/Reference.h"
 #include "detail/TypedReference.h"
 #include "detail/WeakReference.h"
+#include "detail/StackReference.h"
+#include "detail/Coroutine.h"
+#include "detail/Scheduler.h"
+#include "detail/ThreadPool.h"
 #include "detail/functions.h"
+#include "detail/Profiler.h"
+#include "detail/ClassDescriptor.h"
+#include "detail/Objects.h"
 #include "detail/push.h"
 #include "detail/Type.h"
+#include "detail/Table.h"
+#include "detail/Struct.h"
+#include "detail/Columns.h"
+#include "detail/Iterator.h"
 #include "detail/ArgHandler.h"
 #include "detail/CallHelper.h"
 #include "detail/Function.h"
+#include "detail/Property.h"
 #include "detail/ConstructHelper.h"
 #include "detail/Constructor.h"
 #include "detail/Overload.h"
 #include "detail/pull.h"
 #include "detail/register.h"
 #include "detail/StackGuard.h"
+#include "detail/FFI.h"
+#include "detail/Timers.h"
+#include "detail/MappedFile.h"
+#include "detail/Reader.h"
+#include "detail/Budget.h"
+#include "detail/Sampler.h"
+#include "detail/GC.h"
 
 #endif /* !defined LUAWRAPPER_H */
@@ -20,6 +20,10 @@ public:
         basevalue = i;
     }
 
+    int Which (void) {
+        return 1;
+    }
+
     int basevalue;
     static lua::functionlist lua_functions;
 };
@@ -27,7 +31,8 @@ public:
 lua::functionlist Base::lua_functions = {
         { lua::Constructor<Base>::Wrap, lua::CONSTRUCTOR },
         { lua::Destructor<Base>::Wrap, lua::DESTRUCTOR },
-        { "SetBaseValue", lua::Function<void(int)>::Wrap<Base, &Base::SetBaseValue> }
+        { "SetBaseValue", lua::Function<void(int)>::Wrap<Base, &Base::SetBaseValue> },
+        { "Which", lua::Function<int(void)>::Wrap<Base, &Base::Which> }
 
 };
 
@@ -46,6 +51,10 @@ public:
         value = i;
     }
 
+    int Which (void) {
+        return 2;
+    }
+
     int value;
 
     static lua::functionlist lua_functions;
@@ -54,6 +63,7 @@ public:
 lua::functionlist Test::lua_functions = {
         { lua::Constructor<Test>::Wrap, lua::CONSTRUCTOR },
         { lua::Destructor<Test>::Wrap, lua::DESTRUCTOR },
+        { "Which", lua::Function<int(void)>::Wrap<Test, &Test::Which> },
         lua::BaseClass<Base>,
         { "SetValue", lua::Function<void(int)>::Wrap<Test, &Test::SetValue> }
 };
@@ -79,6 +89,11 @@ void runtest (void)
         check (test->basevalue == 66, "correctness of initial base member value");
         runlua (L, "test.SetBaseValue (33)");
         check (test->basevalue == 33, "correctness of base member value after assignment");
+
+        runlua (L, "which = test.Which ()");
+        lua_getglobal (L, "which");
+        check (lua::pull<int> (L, -1) == 2, "derived member overrides base member listed later");
+        lua_pop (L, 1);
     }
     RequireOnce::verify_and_reset_all ();
     {
@@ -0,0 +1,67 @@
+#include "common.h"
+#include <chrono>
+#include <cstring>
+
+void load (lua_State *L, const char *code)
+{
+    if (luaL_loadstring (L, code) != 0) {
+        throw std::runtime_error (lua_tostring (L, -1));
+    }
+}
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+
+    lua::Budget quota (100000, std::chrono::nanoseconds::zero (), lua::Budget::ABORT, 100);
+    load (L, "local x = 0 while true do x = x + 1 end");
+    check (quota.pcall (L, 0, 0) == LUA_ERRRUN && std::strstr (lua_tostring (L, -1), "budget") != nullptr
+           && quota.last ().exceeded && quota.last ().instructions > 100000
+           && quota.last ().instructions <= 100100, "abort on instruction quota");
+    lua_pop (L, 1);
+    check (lua_gethook (L) == nullptr && lua_gethookmask (L) == 0, "hook removed after call");
+
+    load (L, "local x = 0 for i = 1, 1000 do x = x + i end return x");
+    check (quota.pcall (L, 0, 1) == 0 && lua_tointeger (L, -1) == 500500 && !quota.last ().exceeded
+           && quota.last ().instructions > 0 && quota.total ().exceeded, "run within budget");
+    lua_pop (L, 1);
+
+    lua::Budget timeout (0, std::chrono::milliseconds (20));
+    load (L, "while true do end");
+    check (timeout.pcall (L, 0, 0) == LUA_ERRRUN && timeout.last ().exceeded
+           && timeout.last ().elapsed >= std::chrono::milliseconds (20)
+           && timeout.last ().elapsed < std::chrono::seconds (5), "abort on deadline");
+    lua_pop (L, 1);
+
+    load (L, "while true do pcall (function () while true do end end) end");
+    check (quota.pcall (L, 0, 1) == LUA_ERRRUN, "scripts cannot catch the budget error");
+    lua_pop (L, 1);
+
+    lua::Budget slice (10000, std::chrono::nanoseconds::zero (), lua::Budget::YIELD, 100);
+    lua_State *T = lua_newthread (L);
+    load (T, "local x = 0 for i = 1, 100000 do x = x + i end return x");
+    int slices = 0, status;
+    bool preempted = true;
+    while ((status = slice.resume (T, 0)) == LUA_YIELD) {
+        preempted = preempted && slice.last ().exceeded;
+        slices++;
+    }
+    check (preempted, "preempted on instruction quota");
+    check (status == 0 && lua_tonumber (T, -1) == 5000050000.0 && slices > 10, "run in slices");
+    check (!slice.last ().exceeded && slice.total ().instructions >= 10000 * static_cast<std::uint64_t> (slices),
+           "total usage");
+    lua_pop (L, 1);
+
+    T = lua_newthread (L);
+    load (T, "local co = coroutine.create (function () while true do end end) "
+             "local ok = coroutine.resume (co) while true do end");
+    check (slice.resume (T, 0) == LUA_YIELD && slice.last ().exceeded, "abort nested coroutines");
+    lua_pop (L, 1);
+
+    lua_sethook (L, [] (lua_State*, lua_Debug*) {}, LUA_MASKCOUNT, 7);
+    load (L, "return 1");
+    quota.pcall (L, 0, 1);
+    check (lua_gethookmask (L) == LUA_MASKCOUNT && lua_gethookcount (L) == 7, "previous hook restored");
+    lua_pop (L, 1);
+}
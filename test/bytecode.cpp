@@ -0,0 +1,98 @@
+#include "common.h"
+#include <fstream>
+#include <cstdio>
+#include <sys/stat.h>
+#include <dirent.h>
+
+void write (const std::string &path, const std::string &content)
+{
+    std::ofstream file (path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+std::size_t countfiles (const std::string &dir)
+{
+    std::size_t n = 0;
+    DIR *d = opendir (dir.c_str ());
+    while (dirent *entry = readdir (d)) {
+        if (entry->d_name[0] != '.') n++;
+    }
+    closedir (d);
+    return n;
+}
+
+int WriteChunk (lua_State *L, const void *p, std::size_t size, void *ud)
+{
+    static_cast<std::string*> (ud)->append (static_cast<const char*> (p), size);
+    return 0;
+}
+
+// the cache file whose chunk returns value
+std::string findcache (lua_State *L, const std::string &dir, int value)
+{
+    std::string result;
+    DIR *d = opendir (dir.c_str ());
+    while (dirent *entry = readdir (d)) {
+        if (entry->d_name[0] == '.') continue;
+        std::string path = dir + "/" + entry->d_name;
+        if (luaL_loadfile (L, path.c_str ()) == 0 && lua_pcall (L, 0, 1, 0) == 0 && lua_tointeger (L, -1) == value) {
+            result = path;
+        }
+        lua_pop (L, 1);
+    }
+    closedir (d);
+    return result;
+}
+
+void runtest (void)
+{
+    const std::string scripts = "bytecode_scripts", cache = "bytecode_cache";
+    mkdir (scripts.c_str (), 0755);
+    mkdir (cache.c_str (), 0755);
+    DIR *d = opendir (cache.c_str ());
+    while (dirent *entry = readdir (d)) {
+        if (entry->d_name[0] != '.') std::remove ((cache + "/" + entry->d_name).c_str ());
+    }
+    closedir (d);
+
+    for (int i = 0; i < 20; i++) {
+        write (scripts + "/script" + std::to_string (i) + ".lua", "return " + std::to_string (i) + " * 2");
+    }
+    write (scripts + "/broken.lua", "return +");
+
+    check (lua::State::precompile (scripts, cache, 4) == 20 && countfiles (cache) == 20, "precompile script directory");
+    check (lua::State::precompile (scripts, cache, 4) == 0, "precompile skips cached scripts");
+
+    check (lua::State::precompile (scripts, "bytecode_missing", 4) == 0, "precompile into a missing directory");
+
+    lua::State L;
+    const std::string path = scripts + "/script7.lua";
+    check (L.load_cached (path, cache) == 0 && lua_pcall (L, 0, 1, 0) == 0 && lua_tointeger (L, -1) == 14,
+           "load cached chunk");
+    lua_pop (L, 1);
+
+    // replace the cached chunk, which is only seen if the cache is used
+    std::string cachefile = findcache (L, cache, 14), bytecode;
+    luaL_loadstring (L, "return 'cached'");
+    lua_dump (L, WriteChunk, &bytecode);
+    lua_pop (L, 1);
+    write (cachefile, bytecode);
+    check (!cachefile.empty () && L.load_cached (path, cache) == 0 && lua_pcall (L, 0, 1, 0) == 0
+           && std::string (lua_tostring (L, -1)) == "cached" && countfiles (cache) == 20, "cache hit");
+    lua_pop (L, 1);
+
+    write (cachefile, "\033Lua corrupt");
+    check (L.load_cached (path, cache) == 0 && lua_pcall (L, 0, 1, 0) == 0 && lua_tointeger (L, -1) == 14,
+           "corrupt cache falls back to the source");
+    lua_pop (L, 1);
+
+    write (path, "return 'changed'");
+    check (L.load_cached (path, cache) == 0 && lua_pcall (L, 0, 1, 0) == 0 && std::string (lua_tostring (L, -1)) == "changed"
+           && countfiles (cache) == 21, "recompile changed source");
+    lua_pop (L, 1);
+
+    check (L.load_cached (scripts + "/broken.lua", cache) == LUA_ERRSYNTAX && lua_isstring (L, -1), "syntax error");
+    lua_pop (L, 1);
+    check (L.load_cached (scripts + "/missing.lua", cache) == LUA_ERRFILE && lua_gettop (L) == 1, "missing file");
+    lua_pop (L, 1);
+}
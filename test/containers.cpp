@@ -0,0 +1,86 @@
+#include "common.h"
+
+class Test
+{
+public:
+    static std::vector<int> Vector (const std::vector<int> &v) {
+        return std::vector<int> (v.rbegin (), v.rend ());
+    }
+    static std::map<std::string, int> Map (std::map<std::string, int> m) {
+        m["d"] = 4;
+        return m;
+    }
+    static std::array<int, 3> Array (std::array<int, 3> a) {
+        for (int &i : a) i *= 2;
+        return a;
+    }
+    static std::set<std::string> Set (const std::set<std::string> &s) {
+        std::set<std::string> r (s);
+        r.insert ("z");
+        return r;
+    }
+    static std::unordered_set<int> UnorderedSet (const std::unordered_set<int> &s) {
+        return s;
+    }
+    static std::pair<int, std::string> Pair (std::pair<std::string, int> p) {
+        return std::make_pair (p.second, p.first);
+    }
+    static std::tuple<bool, int, std::string> Tuple (std::tuple<int, std::string, bool> t) {
+        return std::make_tuple (!std::get<2> (t), std::get<0> (t) + 1, std::get<1> (t) + "!");
+    }
+#if __cplusplus >= 201703L
+    static std::optional<int> Optional (std::optional<int> o) {
+        return o ? std::optional<int> (*o + 1) : std::nullopt;
+    }
+    static std::string Variant (std::variant<bool, int, std::string, std::vector<int>> v) {
+        switch (v.index ()) {
+        case 0: return "bool";
+        case 1: return "int";
+        case 2: return "string";
+        default: return "vector";
+        }
+    }
+#endif
+    static lua::functionlist lua_functions;
+};
+
+lua::functionlist Test::lua_functions = {
+        { "Vector", lua::Function<std::vector<int>(const std::vector<int>&)>::Wrap<&Test::Vector>, lua::STATIC_FUNCTION },
+        { "Map", lua::Function<std::map<std::string, int>(std::map<std::string, int>)>::Wrap<&Test::Map>, lua::STATIC_FUNCTION },
+        { "Array", lua::Function<std::array<int, 3>(std::array<int, 3>)>::Wrap<&Test::Array>, lua::STATIC_FUNCTION },
+        { "Set", lua::Function<std::set<std::string>(const std::set<std::string>&)>::Wrap<&Test::Set>, lua::STATIC_FUNCTION },
+        { "UnorderedSet", lua::Function<std::unordered_set<int>(const std::unordered_set<int>&)>::Wrap<&Test::UnorderedSet>, lua::STATIC_FUNCTION },
+        { "Pair", lua::Function<std::pair<int, std::string>(std::pair<std::string, int>)>::Wrap<&Test::Pair>, lua::STATIC_FUNCTION },
+        { "Tuple", lua::Function<std::tuple<bool, int, std::string>(std::tuple<int, std::string, bool>)>::Wrap<&Test::Tuple>, lua::STATIC_FUNCTION },
+#if __cplusplus >= 201703L
+        { "Optional", lua::Function<std::optional<int>(std::optional<int>)>::Wrap<&Test::Optional>, lua::STATIC_FUNCTION },
+        { "Variant", lua::Function<std::string(std::variant<bool, int, std::string, std::vector<int>>)>::Wrap<&Test::Variant>, lua::STATIC_FUNCTION },
+#endif
+};
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+
+    lua::register_class<Test> (L, "Test");
+
+    runlua (L, "function check (value, message) assert (value, message) print (message..': passed') end");
+
+    runlua (L, "local v = Test.Vector ({ 1, 2, 3 }) check (#v == 3 and v[1] == 3 and v[3] == 1, 'vector')");
+    runlua (L, "local m = Test.Map ({ a = 1, b = 2 }) check (m.a == 1 and m.b == 2 and m.d == 4, 'map')");
+    runlua (L, "local a = Test.Array ({ 1, 2, 3 }) check (#a == 3 and a[3] == 6, 'array')");
+    dontrunlua (L, "Test.Array ({ 1, 2 })");
+    runlua (L, "local s = Test.Set ({ a = true, b = true }) check (s.a and s.b and s.z and not s.c, 'set')");
+    runlua (L, "local s = Test.UnorderedSet ({ [1] = true, [5] = true }) check (s[1] and s[5] and not s[2], 'unordered set')");
+    dontrunlua (L, "Test.Set ({ 'a' })");
+    runlua (L, "local p = Test.Pair ({ 'x', 1 }) check (p[1] == 1 and p[2] == 'x', 'pair')");
+    runlua (L, "local t = Test.Tuple ({ 1, 'a', false }) check (t[1] == true and t[2] == 2 and t[3] == 'a!', 'tuple')");
+    dontrunlua (L, "Test.Tuple ({ 1, 'a' })");
+#if __cplusplus >= 201703L
+    runlua (L, "check (Test.Optional (1) == 2 and Test.Optional (nil) == nil, 'optional')");
+    runlua (L, "check (Test.Variant (true) == 'bool' and Test.Variant (1) == 'int' and Test.Variant ('1') == 'string'"
+            "and Test.Variant ({ 1 }) == 'vector', 'variant')");
+    dontrunlua (L, "Test.Variant (nil)");
+#endif
+}
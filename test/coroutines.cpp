@@ -0,0 +1,99 @@
+#include "common.h"
+#include <thread>
+#include <chrono>
+
+lua::Scheduler scheduler;
+std::vector<std::thread> workers;
+
+class Test
+{
+public:
+    // completes on a worker thread and resumes the caller through the scheduler;
+    // the token is moved to the worker and on to the completion
+    static lua::Pending Double (lua_State *L, int x) {
+        workers.emplace_back ([] (lua::Pending pending, int x) {
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+            scheduler.post (std::bind ([] (lua::Pending &pending, int x) {
+                int status = pending.resume (2 * x);
+                check (status == 0 || status == LUA_YIELD, "resume pending call");
+            }, std::move (pending), x));
+        }, lua::Pending (L), x);
+        return lua::Pending ();
+    }
+    static lua::functionlist lua_functions;
+};
+
+lua::functionlist Test::lua_functions = {
+        { "Double", lua::Function<lua::Pending(lua_State*, int)>::Wrap<&Test::Double>, lua::STATIC_FUNCTION },
+};
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+
+    lua::register_class<Test> (L, "Test");
+
+    runlua (L, "results = {} function task (x) results[x] = Test.Double (x) + Test.Double (x) end");
+
+    std::vector<lua::Coroutine> tasks;
+    for (int i = 1; i <= 100; i++) {
+        lua_getglobal (L, "task");
+        tasks.emplace_back (L, -1);
+        lua_pop (L, 1);
+        check (tasks.back ().resume (i) == LUA_YIELD, "task suspended");
+    }
+
+    std::size_t completions = 0;
+    while (completions < 200) {
+        scheduler.wait (1000);
+        completions += scheduler.run ();
+    }
+    for (auto &worker : workers) worker.join ();
+
+    bool finished = true;
+    for (auto &task : tasks) finished = finished && task.finished ();
+    check (finished, "all tasks finished");
+    runlua (L, "for i = 1, 100 do assert (results[i] == 4 * i) end");
+
+    check (luaL_dostring (L, "Test.Double (1)") != 0 && std::string (lua_tostring (L, -1)).find ("main thread") != std::string::npos
+           && workers.size () == 200, "pending call on the main thread");
+    lua_pop (L, 1);
+
+    lua_getglobal (L, "task");
+    lua::Coroutine main (L, -1);
+    lua_pop (L, 1);
+    check (main.resume (std::string ("x")) != 0 && main.resume () != 0, "error in coroutine");
+
+    int ran = 0;
+    scheduler.post ([&ran] () { ran++; });
+    scheduler.post ([] () { throw std::runtime_error ("completion failed"); });
+    scheduler.post ([&ran] () { ran++; });
+    bool thrown = false;
+    try {
+        scheduler.run ();
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    check (thrown && ran == 1 && scheduler.wait (0) && scheduler.run () == 1 && ran == 2,
+           "completions after a failed one stay queued");
+
+    lua::ThreadPool pool (L);
+    for (int i = 0; i < 10; i++) {
+        lua::ThreadPool::Thread thread = pool.acquire (true);
+        check (lua_gettop (thread) == 0, "pooled thread has an empty stack");
+        luaL_loadstring (thread, "request = ... return tostring (request)..tostring (results[1])");
+        lua_pushinteger (thread, i);
+        check (lua_resume (thread, 1) == 0 && lua_tostring (thread, -1) == std::to_string (i) + "4", "run request on pooled thread");
+        pool.release (thread);
+    }
+    runlua (L, "assert (request == nil)");
+    check (pool.size () == 1 && pool.available () == 1, "pooled threads reused");
+    lua::ThreadPool::Thread failed = pool.acquire ();
+    luaL_loadstring (failed, "error ('failed')");
+    check (lua_resume (failed, 0) != 0, "error on pooled thread");
+    pool.release (failed);
+    lua::ThreadPool::Thread thread = pool.acquire ();
+    check (lua_status (thread) == 0 && lua_gettop (thread) == 0, "failed pooled thread replaced");
+    pool.release (thread);
+}
@@ -0,0 +1,62 @@
+#include "common.h"
+
+struct Vec2 {
+    float x, y;
+};
+
+namespace lua {
+template<>
+struct FFIType<Vec2> {
+    static std::string name (void) { return "vec2"; }
+};
+} /* namespace lua */
+
+int Add (int a, int b) {
+    return a + b;
+}
+
+double Length (const Vec2 *v) {
+    return v->x + v->y;
+}
+
+void Reset (void) {
+}
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+    L.loadlib (luaopen_package, "package");
+
+    // replace the LuaJIT ffi module by a module recording the declarations
+    runlua (L, R"code(
+package.preload.ffi = function ()
+  return {
+    cdef = function (declarations) cdef = declarations end,
+    cast = function (type, ptr) return { type = type, ptr = ptr } end
+  }
+end
+)code");
+
+    lua::FFIExport ffi;
+    ffi.declare ("typedef struct { float x, y; } vec2;")
+       .add ("Add", Add)
+       .add ("Length", Length)
+       .add ("Reset", Reset);
+    ffi.load (L, "native");
+
+    runlua (L, R"code(
+
+function check (value, message)
+  assert (value, message)
+  print (message..": passed")
+end
+
+check (cdef == "typedef struct { float x, y; } vec2;\n", "ffi declarations")
+check (native.Add.type == "int32_t (*) (int32_t, int32_t)", "ffi signature with integer arguments")
+check (native.Length.type == "double (*) (const vec2 *)", "ffi signature with struct pointer")
+check (native.Reset.type == "void (*) (void)", "ffi signature without arguments")
+check (type (native.Add.ptr) == "userdata", "ffi function pointer")
+
+)code");
+}
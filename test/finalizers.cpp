@@ -0,0 +1,38 @@
+#include "common.h"
+
+static int destructed = 0;
+
+class Test
+{
+public:
+    ~Test (void) {
+        destructed++;
+    }
+
+    static lua::functionlist lua_functions;
+};
+
+lua::functionlist Test::lua_functions = {
+        { lua::Constructor<Test>::Wrap, lua::CONSTRUCTOR },
+        { lua::DeferredDestructor<Test>::Wrap, lua::DESTRUCTOR }
+};
+
+void runtest (void)
+{
+    {
+        lua::State L;
+        lua::register_class<Test> (L, "Test");
+
+        runlua (L, "a = Test() b = Test() c = Test()");
+        runlua (L, "a = nil b = nil c = nil");
+        lua_gc (L, LUA_GCCOLLECT, 0);
+        check (destructed == 0, "destruction deferred during garbage collection");
+
+        check (L.drain_finalizers (2) == 2 && destructed == 2, "draining with budget");
+        check (L.drain_finalizers () == 1 && destructed == 3, "draining remaining objects");
+        check (L.drain_finalizers () == 0, "draining empty queue");
+
+        runlua (L, "d = Test()");
+    }
+    check (destructed == 4, "deferred destruction on closing the state");
+}
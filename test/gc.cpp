@@ -0,0 +1,73 @@
+#include "common.h"
+#include <chrono>
+
+class Test
+{
+public:
+    Test (int value) : value (value) {}
+    int Get (void) {
+        return value;
+    }
+    static lua::functionlist lua_functions;
+private:
+    int value;
+};
+
+lua::functionlist Test::lua_functions = {
+        { lua::Constructor<Test, int>::Wrap, lua::CONSTRUCTOR },
+        { "Get", lua::Function<int(void)>::Wrap<Test, &Test::Get> },
+        { lua::Destructor<Test>::Wrap, lua::DESTRUCTOR }
+};
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+    lua::register_class<Test> (L, "Test");
+    lua::GC gc = L.gc ();
+
+    std::size_t counted = static_cast<std::size_t> (lua_gc (L, LUA_GCCOUNT, 0)) * 1024 + lua_gc (L, LUA_GCCOUNTB, 0);
+    check (gc.inuse () == counted, "count bytes in use");
+    check (gc.allocated () == 0 || gc.allocated () - gc.freed () == gc.inuse (), "allocator counters");
+
+    gc.preset (lua::GC::LOW_LATENCY);
+    check (gc.pause (200) == 150 && gc.stepmul (200) == 100, "presets");
+
+    std::size_t callbacks = 0, freed = 0;
+    gc.on_stats ([&] (const lua::GC::Stats &stats) {
+        callbacks++;
+        freed += stats.freed;
+    });
+
+    {
+        lua::GC::Stop stop (gc);
+        {
+            lua::GC::Stop nested (gc);
+        }
+        check (gc.stopped (), "nested stop keeps the collector stopped");
+        std::size_t before = gc.inuse ();
+        runlua (L, "for i = 1, 20000 do local t = Test (i) end");
+        check (gc.inuse () > before + 20000 * sizeof (void*), "no collection while stopped");
+    }
+    check (!gc.stopped (), "restart after the outermost stop");
+
+    bool bounded = true, cycle = false;
+    int steps = 0;
+    for (int i = 0; i < 10000 && !cycle; i++) {
+        lua::GC::Stats stats = gc.step (std::chrono::microseconds (200));
+        bounded = bounded && stats.steps >= 1 && stats.duration < std::chrono::milliseconds (50);
+        cycle = stats.cycle;
+        steps += stats.steps;
+    }
+    check (cycle && bounded && steps > 1, "step with time budget");
+    check (callbacks > 0 && freed > 0, "stats callback");
+
+    runlua (L, "garbage = {} for i = 1, 1000 do garbage[i] = Test (i) end");
+    runlua (L, "garbage = nil");
+    lua::GC::Stats stats = gc.collect ();
+    check (stats.cycle && stats.freed > 1000 * sizeof (void*) && stats.inuse == gc.inuse (), "full collection");
+
+    lua::State moved (std::move (L));
+    runlua (moved, "x = Test (1)");
+    check (moved.gc ().inuse () > 0, "move state with its allocator");
+}
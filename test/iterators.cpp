@@ -0,0 +1,67 @@
+#include "common.h"
+#include <map>
+#include <functional>
+
+class Counted
+{
+public:
+    Counted (void) { instances++; }
+    Counted (const Counted &c) : values (c.values) { instances++; }
+    Counted (Counted &&c) : values (std::move (c.values)) { instances++; }
+    ~Counted (void) { instances--; }
+    std::vector<int>::const_iterator begin (void) const { return values.begin (); }
+    std::vector<int>::const_iterator end (void) const { return values.end (); }
+    std::vector<int> values;
+    static int instances;
+};
+
+int Counted::instances = 0;
+
+class Test
+{
+public:
+    static lua::RangeIteration<std::map<std::string, int>::const_iterator> Items (void) {
+        return lua::Iterate (items);
+    }
+    static lua::OwnedIteration<Counted> Owned (int n) {
+        Counted c;
+        for (int i = 1; i <= n; i++) c.values.push_back (i);
+        return lua::Iterate (std::move (c));
+    }
+    static std::function<bool(int&)> Counter (int n) {
+        return [n] (int &v) mutable {
+            v = n--;
+            return v > 0;
+        };
+    }
+    static lua::Generator<int, std::function<bool(int&)>> Countdown (int n) {
+        return lua::Generate<int> (Counter (n));
+    }
+    static const std::map<std::string, int> items;
+    static lua::functionlist lua_functions;
+};
+
+const std::map<std::string, int> Test::items = { { "a", 1 }, { "b", 2 }, { "c", 3 } };
+
+lua::functionlist Test::lua_functions = {
+        { "Items", lua::Function<lua::RangeIteration<std::map<std::string, int>::const_iterator>(void)>::Wrap<&Test::Items>, lua::STATIC_FUNCTION },
+        { "Owned", lua::Function<lua::OwnedIteration<Counted>(int)>::Wrap<&Test::Owned>, lua::STATIC_FUNCTION },
+        { "Countdown", lua::Function<lua::Generator<int, std::function<bool(int&)>>(int)>::Wrap<&Test::Countdown>, lua::STATIC_FUNCTION },
+};
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+
+    lua::register_class<Test> (L, "Test");
+
+    runlua (L, "function check (value, message) assert (value, message) print (message..': passed') end");
+
+    runlua (L, "local s = '' for k, v in Test.Items () do s = s..k..v end check (s == 'a1b2c3', 'iterate map')");
+    runlua (L, "local s = 0 for i, v in Test.Owned (100) do s = s + i * v end check (s == 338350, 'iterate owned range')");
+    runlua (L, "for i, v in Test.Owned (10) do if i == 3 then break end end");
+    lua_gc (L, LUA_GCCOLLECT, 0);
+    check (Counted::instances == 0, "iteration state destroyed after break");
+    runlua (L, "local s = '' for v in Test.Countdown (3) do s = s..v end check (s == '321', 'generator')");
+}
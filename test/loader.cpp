@@ -0,0 +1,119 @@
+#include "common.h"
+#include <fstream>
+#include <sstream>
+#include <list>
+#include <fcntl.h>
+#include <unistd.h>
+
+// sums the numbers 1..n in a chunk much larger than the block size
+std::string generate (int n)
+{
+    std::string source = "local t = {";
+    for (int i = 1; i <= n; i++) {
+        source += std::to_string (i) + ",\n";
+    }
+    return source + "}\nlocal sum = 0\nfor i = 1, #t do sum = sum + t[i] end\nreturn sum\n";
+}
+
+bool runchunk (lua::State &L, int status, lua_Number expected)
+{
+    if (status != 0) {
+        lua_pop (L, 1);
+        return false;
+    }
+    bool result = lua_pcall (L, 0, 1, 0) == 0 && lua_tonumber (L, -1) == expected;
+    lua_pop (L, 1);
+    return result;
+}
+
+class FailingReader : public lua::Reader {
+public:
+    const char *read (std::size_t &size) override {
+        if (calls++ > 0) throw std::runtime_error ("reader failed");
+        size = 10;
+        return "return 1 +";
+    }
+private:
+    int calls = 0;
+};
+
+void runtest (void)
+{
+    const int n = 20000;
+    const lua_Number expected = static_cast<lua_Number> (n) * (n + 1) / 2;
+    const std::string source = generate (n), path = "loader_chunk.lua";
+    {
+        std::ofstream file (path, std::ios::binary | std::ios::trunc);
+        file << source;
+    }
+
+    lua::State L;
+    {
+        lua::FileReader reader (path, 4096);
+        check (runchunk (L, L.load (reader, "@" + path), expected), "file reader");
+    }
+    {
+        int fd = open (path.c_str (), O_RDONLY);
+        lua::FileReader reader (fd, 1000);
+        check (runchunk (L, L.load (reader, "=fd"), expected), "file descriptor reader");
+        close (fd);
+    }
+    {
+        lua::MappedReader reader (path, 4096);
+        check (runchunk (L, L.load (reader, "@" + path), expected), "mapped reader");
+    }
+    {
+        std::istringstream stream (source);
+        lua::StreamReader reader (stream, 333);
+        check (runchunk (L, L.load (reader, "=stream"), expected), "stream reader");
+    }
+    {
+        std::list<char> chars (source.begin (), source.end ());
+        auto reader = lua::MakeReader (chars.begin (), chars.end (), 512);
+        check (runchunk (L, L.load (reader, "=list"), expected), "iterator reader");
+    }
+    {
+        std::string code = "return 'single block'";
+        auto reader = lua::MakeReader (code.begin (), code.end ());
+        check (L.load (reader, "=small") == 0 && lua_pcall (L, 0, 1, 0) == 0
+               && std::string (lua_tostring (L, -1)) == "single block", "default block size");
+        lua_pop (L, 1);
+    }
+    {
+        std::string code = "return +";
+        auto reader = lua::MakeReader (code.begin (), code.end (), 3);
+        check (L.load (reader, "=broken") == LUA_ERRSYNTAX && lua_isstring (L, -1), "syntax error");
+        lua_pop (L, 1);
+    }
+    {
+        FailingReader reader;
+        check (L.load (reader, "=failing") == LUA_ERRFILE && std::string (lua_tostring (L, -1)) == "reader failed"
+               && lua_gettop (L) == 1, "reader exception");
+        lua_pop (L, 1);
+    }
+    bool thrown = false;
+    try {
+        lua::FileReader reader ("loader_missing.lua");
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    check (thrown, "missing file");
+    int rejected = 0;
+    try {
+        lua::FileReader reader (path, 0);
+    } catch (const std::runtime_error &) {
+        rejected++;
+    }
+    try {
+        lua::MappedReader reader (path, 0);
+    } catch (const std::runtime_error &) {
+        rejected++;
+    }
+    try {
+        auto reader = lua::MakeReader (source.begin (), source.end (), 0);
+    } catch (const std::runtime_error &) {
+        rejected++;
+    }
+    check (rejected == 3, "block size of 0");
+    std::remove (path.c_str ());
+}
@@ -0,0 +1,100 @@
+#include "common.h"
+#include <algorithm>
+
+class Test
+{
+public:
+    Test (int value) : value (value) {}
+    int Get (void) {
+        return value;
+    }
+    static lua::functionlist lua_functions;
+private:
+    int value;
+    char payload[100];
+};
+
+lua::functionlist Test::lua_functions = {
+        { lua::Constructor<Test, int>::Wrap, lua::CONSTRUCTOR },
+        { "Get", lua::Function<int(void)>::Wrap<Test, &Test::Get> },
+        { lua::Destructor<Test>::Wrap, lua::DESTRUCTOR }
+};
+
+class Deferred
+{
+public:
+    static lua::functionlist lua_functions;
+};
+
+lua::functionlist Deferred::lua_functions = {
+        { lua::Constructor<Deferred>::Wrap, lua::CONSTRUCTOR },
+        { lua::DeferredDestructor<Deferred>::Wrap, lua::DESTRUCTOR }
+};
+
+// never registered and without destructor, i.e. leaked by lua
+class Leaked
+{
+public:
+    static lua::functionlist lua_functions;
+};
+
+lua::functionlist Leaked::lua_functions = {
+};
+
+const lua::ObjectCount *find (const std::vector<lua::ObjectCount> &counts, const std::string &name)
+{
+    auto it = std::find_if (counts.begin (), counts.end (), [&] (const lua::ObjectCount &count) {
+        return count.name == name;
+    });
+    return it != counts.end () ? &*it : nullptr;
+}
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+    lua::register_class<Test> (L, "Test");
+    lua::register_class<Deferred> (L, "Deferred");
+    lua::register_class (L, "objects", lua::Objects::lua_functions);
+
+    runlua (L, "kept = {} for i = 1, 100 do local t = Test (i) if i <= 10 then kept[i] = t end end");
+    lua::push (L, Test (1000));
+    lua_setglobal (L, "pushed");
+    lua_gc (L, LUA_GCCOLLECT, 0);
+
+    auto counts = L.objects ();
+    const lua::ObjectCount *test = find (counts, "Test");
+    check (test != nullptr && test->created == 101 && test->live == 11 && test->bytes == 11 * sizeof (Test),
+           "count constructed and pushed objects");
+
+    runlua (L, "for i = 1, 5 do Deferred () end");
+    lua_gc (L, LUA_GCCOLLECT, 0);
+    counts = L.objects ();
+    const lua::ObjectCount *deferred = find (counts, "Deferred");
+    check (deferred != nullptr && deferred->created == 5 && deferred->live == 0, "count deferred destruction");
+    L.drain_finalizers ();
+
+    // adds a counter while the destructors of the kept objects hold pointers to theirs
+    lua::push (L, Leaked ());
+    lua_pop (L, 1);
+    lua_gc (L, LUA_GCCOLLECT, 0);
+    counts = L.objects ();
+    const lua::ObjectCount *leaked = find (counts, typeid (Leaked).name ());
+    check (leaked != nullptr && leaked->live == 1, "fall back to the type name");
+
+    runlua (L, R"code(
+function check (value, message)
+  assert (value, message)
+  print (message..": passed")
+end
+local counts = objects.counts ()
+check (counts.Test.live == 11 and counts.Test.created == 101, "counts from lua")
+kept = nil
+pushed = nil
+collectgarbage ()
+check (objects.counts ().Test.live == 0 and objects.counts ().Test.bytes == 0, "count destroyed objects")
+)code");
+
+    lua::State other;
+    check (other.objects ().empty (), "counters per state");
+}
@@ -0,0 +1,108 @@
+#include "common.h"
+#include <algorithm>
+
+class Test
+{
+public:
+    Test (int value) : value (value) {}
+    int Add (int x) {
+        return value + x;
+    }
+    int Add (std::string str) {
+        return value + str.length ();
+    }
+    static int Twice (int x) {
+        return 2 * x;
+    }
+    static lua::functionlist lua_functions;
+private:
+    int value;
+};
+
+lua::functionlist Test::lua_functions = {
+        { lua::Constructor<Test, int>::Wrap, lua::CONSTRUCTOR },
+        { "Add", lua::Overload<lua::Function<int(int)>::Wrap<Test, &Test::Add>,
+                lua::Function<int(std::string)>::Wrap<Test, &Test::Add>> },
+        { "Twice", lua::Function<int(int)>::Wrap<&Test::Twice>, lua::STATIC_FUNCTION }
+};
+
+int Sum (int a, int b)
+{
+    return a + b;
+}
+
+lua::functionlist util_functions = {
+        { "Sum", lua::Function<int(int, int)>::Wrap<&Sum>, lua::STATIC_FUNCTION }
+};
+
+const lua::Profiler::Statistics *find (const std::vector<lua::Profiler::Statistics> &statistics,
+                                       const std::string &classname, const std::string &name)
+{
+    auto it = std::find_if (statistics.begin (), statistics.end (), [&] (const lua::Profiler::Statistics &s) {
+        return s.classname == classname && s.name == name;
+    });
+    return it != statistics.end () ? &*it : nullptr;
+}
+
+std::uint64_t completed (const lua::Profiler::Statistics &statistics)
+{
+    std::uint64_t total = 0;
+    for (auto count : statistics.histogram) total += count;
+    return total;
+}
+
+void runtest (void)
+{
+    bool buckets = true;
+    for (std::uint64_t ns : { 0ull, 1ull, 5ull, 100ull, 12345ull, 1000000007ull }) {
+        int b = lua::Profiler::bucket (ns);
+        buckets = buckets && lua::Profiler::bucket_limit (b) <= ns && ns < lua::Profiler::bucket_limit (b + 1)
+                  && ns - lua::Profiler::bucket_limit (b) <= ns / lua::Profiler::SUBBUCKETS;
+    }
+    check (buckets, "histogram buckets");
+
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+    lua::register_class<Test> (L, "Test");
+    lua::register_class (L, "util", util_functions);
+
+    runlua (L, R"code(
+local test = Test (1)
+for i = 1, 100 do
+  test.Add (i)
+end
+test.Add ("abc")
+Test.Twice (3)
+util.Sum (1, 2)
+pcall (Test, "no number")
+)code");
+    dontrunlua (L, "Test.Twice ('x')");
+
+    auto statistics = lua::Profiler::statistics ();
+    const lua::Profiler::Statistics *add = find (statistics, "Test", "Add");
+    check (add != nullptr && add->calls == 101 && completed (*add) == 101 && add->failed == 1, "count overloads");
+    const lua::Profiler::Statistics *twice = find (statistics, "Test", "Twice");
+    check (twice != nullptr && twice->calls == 2 && completed (*twice) == 1 && twice->failed == 1, "count failed calls");
+    const lua::Profiler::Statistics *constructor = find (statistics, "Test", "constructor");
+    check (constructor != nullptr && constructor->calls == 2 && constructor->failed == 1, "count constructors");
+    const lua::Profiler::Statistics *sum = find (statistics, "util", "Sum");
+    check (sum != nullptr && sum->calls == 1, "name function lists");
+    check (add->percentile (0.5) <= add->percentile (0.99) && add->percentile (0.99) <= add->percentile (1.0)
+           && add->percentile (1.0) > 0, "percentiles");
+
+    // a failed check of a wrapper pushed without the profiler is not charged to the last binding
+    lua_pushcfunction (L, lua::Function<int(int)>::Wrap<&Test::Twice>);
+    lua_setglobal (L, "twice");
+    runlua (L, "Test.Twice (4) assert (not pcall (twice, 'x'))");
+    statistics = lua::Profiler::statistics ();
+    twice = find (statistics, "Test", "Twice");
+    check (twice != nullptr && twice->calls == 3 && twice->failed == 1, "ignore unprofiled wrappers");
+
+    std::string json = lua::Profiler::json (), text = lua::Profiler::text ();
+    check (json.find ("{\"class\":\"Test\",\"function\":\"Add\",\"calls\":101,\"failed_checks\":1,") != std::string::npos
+           && json.front () == '{' && json.back () == '}', "export json");
+    check (text.find ("Test.Add: 101 calls, 1 failed checks") != std::string::npos, "export text");
+
+    lua::Profiler::reset ();
+    check (lua::Profiler::statistics ().empty (), "reset");
+}
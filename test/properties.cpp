@@ -0,0 +1,92 @@
+#include "common.h"
+
+class Base
+{
+public:
+    Base (void) : basevalue (3) {
+    }
+
+    int basevalue;
+
+    static lua::functionlist lua_functions;
+};
+
+lua::functionlist Base::lua_functions = {
+        { "basevalue", lua::Property<int>::Wrap<Base, &Base::basevalue> }
+};
+
+class Test : public Base
+{
+public:
+    Test (void) : value (42), name ("test"), readonly (7), writeonly (0) {
+    }
+
+    int GetWriteOnly (void) {
+        return writeonly;
+    }
+
+    static int Index (lua_State *L) {
+        lua_pushstring (L, "fallback");
+        return 1;
+    }
+
+    int value;
+    std::string name;
+    int readonly;
+    int writeonly;
+
+    static lua::functionlist lua_functions;
+};
+
+lua::functionlist Test::lua_functions = {
+        { lua::Constructor<Test>::Wrap, lua::CONSTRUCTOR },
+        { lua::Destructor<Test>::Wrap, lua::DESTRUCTOR },
+        lua::BaseClass<Base>,
+        { "value", lua::Property<int>::Wrap<Test, &Test::value> },
+        { "name", lua::Property<std::string>::Wrap<Test, &Test::name> },
+        { "readonly", lua::Property<int>::ReadOnly<Test, &Test::readonly> },
+        { "writeonly", lua::Property<int>::WriteOnly<Test, &Test::writeonly> },
+        { "GetWriteOnly", lua::Function<int(void)>::Wrap<Test, &Test::GetWriteOnly> },
+        { Test::Index, lua::INDEX_FUNCTION }
+};
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+    lua::register_class<Test> (L, "Test");
+
+    runlua (L, R"code(
+
+function check (value, message)
+  assert (value, message)
+  print (message..": passed")
+end
+
+test = Test()
+check (test.value == 42, "property read")
+test.value = 21
+check (test.value == 21, "property write")
+check (test.name == "test", "string property read")
+test.name = "other"
+check (test.name == "other", "string property write")
+check (test.readonly == 7, "read-only property read")
+test.writeonly = 5
+check (test.GetWriteOnly () == 5, "write-only property write")
+check (test.basevalue == 3, "base class property read")
+test.basevalue = 4
+check (test.basevalue == 4, "base class property write")
+check (test.unknown == "fallback", "index function fallback")
+
+)code");
+
+    dontrunlua (L, "test.readonly = 1");
+    dontrunlua (L, "local x = test.writeonly");
+    dontrunlua (L, "test.value = 'string'");
+    dontrunlua (L, "test.unknown = 1");
+
+    lua_getglobal (L, "test");
+    Test *test = lua::pull<Test*> (L, -1);
+    lua_pop (L, 1);
+    check (test->value == 21 && test->name == "other" && test->basevalue == 4, "property values on the C++ side");
+}
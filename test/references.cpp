@@ -1,5 +1,6 @@
 #include "common.h"
 #include "Object.h"
+#include <unordered_map>
 
 class Test
 {
@@ -67,8 +68,22 @@ public:
     static void F20 (lua::TypedReference<Object*> ref) {
         check (ref.isnil (), "nil passed as typed reference by value");
     }
+    static void F21 (lua::StackReference ref) {
+        check (ref.checktype<int> () && ref.convert<int> () == 221 && !ref.isnil (), "integer stack reference");
+    }
+    static void F22 (const lua::ArgRef<std::string> &ref) {
+        check (ref.get () == "222", "string stack reference");
+        kept = ref.promote ();
+    }
+    static void F23 (lua::ArgRef<Object> ref) {
+        check (ref.get ().checkstate (EXPLICIT, false, false, 223), "object stack reference");
+    }
+    static lua::StackReference F24 (lua::StackReference ref) {
+        return ref;
+    }
 
 
+    static lua::Reference kept;
     static lua::functionlist lua_functions;
 };
 
@@ -93,8 +108,14 @@ lua::functionlist Test::lua_functions = {
         { "F18", lua::Function<void(lua::TypedReference<Object>&&)>::Wrap<&Test::F18>, lua::STATIC_FUNCTION },
         { "F19", lua::Function<lua::Reference(lua_State*)>::Wrap<&Test::F19>, lua::STATIC_FUNCTION },
         { "F20", lua::Function<void(lua::TypedReference<Object*>)>::Wrap<&Test::F20>, lua::STATIC_FUNCTION },
+        { "F21", lua::Function<void(lua::StackReference)>::Wrap<&Test::F21>, lua::STATIC_FUNCTION },
+        { "F22", lua::Function<void(const lua::ArgRef<std::string>&)>::Wrap<&Test::F22>, lua::STATIC_FUNCTION },
+        { "F23", lua::Function<void(lua::ArgRef<Object>)>::Wrap<&Test::F23>, lua::STATIC_FUNCTION },
+        { "F24", lua::Function<lua::StackReference(lua::StackReference)>::Wrap<&Test::F24>, lua::STATIC_FUNCTION },
 };
 
+lua::Reference Test::kept;
+
 void runtest (void)
 {
     lua::State L;
@@ -115,4 +136,85 @@ void runtest (void)
             "Test.F16 (Object (216)) Test.F17 (Object (217)) Test.F18 (Object (218))"
             "check (Test.F19 () == 219, 'return integer reference by value')");
     runlua (L, "Test.F20 (nil)");
+    runlua (L, "Test.F21 (221) Test.F22 ('222') Test.F23 (Object (223))"
+            "check (Test.F24 ('stack') == 'stack', 'return stack reference')");
+    dontrunlua (L, "Test.F22 ({})");
+    check (Test::kept.convert<std::string> () == "222", "promoted stack reference");
+    Test::kept.reset ();
+
+    {
+        lua_pushinteger (L, 300);
+        lua::Reference ref (L, -1);
+        lua_pop (L, 1);
+        std::vector<lua::Reference> copies (16, ref);
+        ref.reset ();
+        check (copies.front () == copies.back () && copies.back ().convert<int> () == 300, "copied references share the value");
+        copies.erase (copies.begin (), copies.end () - 1);
+        check (copies.front ().valid () && copies.front ().convert<int> () == 300, "last copy of a reference stays valid");
+    }
+
+    {
+        lua_newtable (L);
+        lua::Reference strong (L, -1);
+        lua::WeakReference weak[3] = { lua::WeakReference (L, -1), lua::WeakReference (), lua::WeakReference () };
+        lua_pop (L, 1);
+        lua_newtable (L);
+        weak[1] = lua::WeakReference (L, -1);
+        lua_pop (L, 1);
+        unsigned int generation = lua::WeakReference::generation (L);
+        lua_gc (L, LUA_GCCOLLECT, 0);
+        check (lua::WeakReference::generation (L) != generation, "collection changes the weak reference generation");
+        bool results[3];
+        check (lua::WeakReference::valid (weak, 3, results) == 1 && results[0] && !results[1] && !results[2],
+               "batched weak reference validity");
+        check (weak[0].valid () && !weak[1].valid (), "weak reference validity");
+        lua_State *T = lua_newthread (L);
+        lua::Type<lua::WeakReference>::push (T, weak[0]);
+        lua::Type<lua::WeakReference>::push (T, weak[1]);
+        strong.push ();
+        lua_xmove (L, T, 1);
+        check (lua_gettop (T) == 3 && lua_rawequal (T, 1, 3) && lua_isnil (T, 2), "push weak reference onto another thread");
+        lua_pop (L, 1);
+        strong.reset ();
+        lua_gc (L, LUA_GCCOLLECT, 0);
+        check (!weak[0].valid (), "weak reference invalid after collection");
+    }
+
+    {
+        lua_State *raw = luaL_newstate ();
+        lua_pushinteger (raw, 400);
+        lua::WeakReference weak (raw, -1);
+        lua_pop (raw, 1);
+        check (weak.valid () && weak.convert<int> () == 400, "weak reference without lua::State");
+        weak.reset ();
+        lua_close (raw);
+    }
+
+    {
+        std::unordered_map<lua::Reference, int, std::hash<lua::Reference>, lua::Reference::RawEqual> map;
+        lua_newtable (L);
+        lua::Reference table (L, -1);
+        lua_pop (L, 1);
+        map[table] = 1;
+        lua_pushstring (L, "key");
+        map[lua::Reference (L, -1)] = 2;
+        lua_pop (L, 1);
+        lua_pushnumber (L, 3.5);
+        map[lua::Reference (L, -1)] = 3;
+        lua_pop (L, 1);
+        table.push ();
+        lua_pushliteral (L, "k");
+        lua_pushliteral (L, "e");
+        lua_concat (L, 2);
+        lua_pushinteger (L, 0);
+        lua::Reference t2 (L, -3), s2 (L, -2), n2 (L, -1);
+        lua_pop (L, 3);
+        check (map.size () == 3 && map[t2] == 1 && map.count (s2) == 0 && map.count (n2) == 0, "hashed table and string references");
+        lua_pushliteral (L, "key");
+        lua_pushnumber (L, 3.5);
+        lua::Reference s3 (L, -2), n3 (L, -1);
+        lua_pop (L, 2);
+        check (map[s3] == 2 && map[n3] == 3 && s3 == lua::Reference (s3) && !(s3 == s2), "hashed string and number references");
+        check (n2.rawequal (n2) && !n2.rawequal (n3) && std::hash<lua::Reference> () (s3) == s3.hash (), "raw equality");
+    }
 }
@@ -0,0 +1,109 @@
+#include "common.h"
+#include <sstream>
+
+class Test
+{
+public:
+    // runs a lua callback, so that samples are taken inside the bound function
+    static int Work (lua_State *L) {
+        int sum = 0;
+        for (int i = 0; i < 10; i++) {
+            lua_pushvalue (L, 1);
+            lua_call (L, 0, 1);
+            sum += lua_tointeger (L, -1);
+            lua_pop (L, 1);
+        }
+        lua_pushinteger (L, sum);
+        return 1;
+    }
+    // starts or stops the sampler from inside a script
+    static int Sample (lua_State *L) {
+        if (lua_toboolean (L, 1)) sampler->start ();
+        else sampler->stop ();
+        return 0;
+    }
+    static lua::Sampler *sampler;
+    static lua::functionlist lua_functions;
+};
+
+lua::Sampler *Test::sampler = nullptr;
+
+lua::functionlist Test::lua_functions = {
+        { "Work", Test::Work, lua::STATIC_FUNCTION },
+        { "Sample", Test::Sample, lua::STATIC_FUNCTION }
+};
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+    lua::register_class<Test> (L, "Test");
+
+    lua::Sampler sampler (L, 100);
+    sampler.start ();
+    runlua (L, R"code(
+function inner ()
+  local x = 0
+  for i = 1, 1000 do x = x + i end
+  return x
+end
+function outer ()
+  return Test.Work (inner)
+end
+for i = 1, 200 do outer () end
+)code");
+    sampler.stop ();
+    check (lua_gethook (L) == nullptr, "stop removes the hook");
+
+    std::string folded = sampler.folded ();
+    std::uint64_t total = 0;
+    bool wellformed = true;
+    std::istringstream lines (folded);
+    std::string line;
+    while (std::getline (lines, line)) {
+        std::size_t space = line.rfind (' ');
+        wellformed = wellformed && space != std::string::npos && space > 0;
+        if (wellformed) total += std::stoull (line.substr (space + 1));
+    }
+    check (sampler.samples () > 100 && total == sampler.samples () && wellformed, "folded stack counts");
+    check (folded.find (";Test.Work;") != std::string::npos, "name bound functions");
+    check (folded.find ("main [string") == 0, "outermost frame first");
+    check (folded.find (":2 ") != std::string::npos || folded.find (":2;") != std::string::npos, "name lua functions");
+
+    sampler.clear ();
+    check (sampler.samples () == 0 && sampler.folded ().empty (), "clear samples");
+    sampler.start ();
+    runlua (L, "co = coroutine.create (function () local x = 0 for i = 1, 100000 do x = x + i end end) coroutine.resume (co)");
+    sampler.stop ();
+    check (sampler.samples () > 100, "sample coroutines created while running");
+
+    // the budget counts the instructions run while sampling and is restored by stop
+    sampler.clear ();
+    Test::sampler = &sampler;
+    lua::Budget quota (150000, std::chrono::nanoseconds::zero (), lua::Budget::ABORT, 100);
+    luaL_loadstring (L, "Test.Sample (true) for i = 1, 100000 do end Test.Sample (false) for i = 1, 100000 do end");
+    check (quota.pcall (L, 0, 0) == LUA_ERRRUN && quota.last ().exceeded && sampler.samples () > 100,
+           "sampler inside a budget");
+    lua_pop (L, 1);
+    check (lua_gethook (L) == nullptr, "budget hook restored");
+
+    // a budget exceeded while sampling replaces the sampler hook, which stop leaves alone
+    sampler.clear ();
+    lua::Budget small (50000, std::chrono::nanoseconds::zero (), lua::Budget::ABORT, 100);
+    luaL_loadstring (L, "Test.Sample (true) while true do end");
+    check (small.pcall (L, 0, 0) == LUA_ERRRUN && small.last ().exceeded && sampler.samples () > 100,
+           "budget exceeded while sampling");
+    lua_pop (L, 1);
+    sampler.stop ();
+    check (lua_gethook (L) == nullptr, "no hook after an exceeded budget");
+
+    // a budget call started while sampling keeps calling the sampler
+    sampler.clear ();
+    sampler.start ();
+    luaL_loadstring (L, "for i = 1, 100000 do end");
+    check (quota.pcall (L, 0, 0) == 0 && quota.last ().instructions >= 100000 && sampler.samples () > 100,
+           "budget inside a sampler");
+    check (lua_gethook (L) != nullptr, "sampler hook restored by the budget");
+    sampler.stop ();
+    check (lua_gethook (L) == nullptr, "no hook after sampling around a budget");
+}
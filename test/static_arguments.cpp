@@ -1,5 +1,6 @@
 #include "common.h"
 #include "Object.h"
+#include <cstring>
 
 class Test
 {
@@ -65,6 +66,18 @@ public:
         check (b->checkstate (DEFAULT, false, false, 53) && Object::count == 1, "base passed by pointer");
     }
 
+    static void F16 (lua::StringView s) {
+        check (s == lua::StringView { "string view", 11 }, s.str ());
+    }
+    static void F17 (const char *s) {
+        check (!std::strcmp (s, "c string"), s);
+    }
+#if __cplusplus >= 201703L
+    static void F18 (std::string_view s) {
+        check (s == "std::string_view", std::string (s));
+    }
+#endif
+
     static lua::functionlist lua_functions;
 };
 
@@ -83,7 +96,12 @@ lua::functionlist Test::lua_functions = {
         { "F12", lua::Function<void(const std::string&)>::Wrap<&Test::F12>, lua::STATIC_FUNCTION },
         { "F13", lua::Function<void(std::string&&)>::Wrap<&Test::F13>, lua::STATIC_FUNCTION },
         { "F14", lua::Function<void(Base&)>::Wrap<&Test::F14>, lua::STATIC_FUNCTION },
-        { "F15", lua::Function<void(Base*)>::Wrap<&Test::F15>, lua::STATIC_FUNCTION }
+        { "F15", lua::Function<void(Base*)>::Wrap<&Test::F15>, lua::STATIC_FUNCTION },
+        { "F16", lua::Function<void(lua::StringView)>::Wrap<&Test::F16>, lua::STATIC_FUNCTION },
+        { "F17", lua::Function<void(const char*)>::Wrap<&Test::F17>, lua::STATIC_FUNCTION },
+#if __cplusplus >= 201703L
+        { "F18", lua::Function<void(std::string_view)>::Wrap<&Test::F18>, lua::STATIC_FUNCTION },
+#endif
 };
 
 void runtest (void)
@@ -137,4 +155,9 @@ void runtest (void)
     obj->value = 53;
     Object::count = 1;
     runlua (L, "Test.F15 (object)");
+
+    runlua (L, "Test.F16 (\"string view\") Test.F17 (\"c string\")");
+#if __cplusplus >= 201703L
+    runlua (L, "Test.F18 (\"std::string_view\")");
+#endif
 }
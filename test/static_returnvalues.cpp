@@ -62,6 +62,13 @@ public:
         return new Object (58);
     }
 
+    static lua::StringView F16 (void) {
+        return lua::StringView { "F16", 3 };
+    }
+    static const char *F17 (void) {
+        return "F17";
+    }
+
     static lua::functionlist lua_functions;
 };
 
@@ -80,7 +87,9 @@ lua::functionlist Test::lua_functions = {
         { "F12", lua::Function<Object&(void)>::Wrap<&Test::F12>, lua::STATIC_FUNCTION },
         { "F13", lua::Function<Object&&(void)>::Wrap<&Test::F13>, lua::STATIC_FUNCTION },
         { "F14", lua::Function<Object*(void)>::Wrap<&Test::F14>, lua::STATIC_FUNCTION },
-        { "F15", lua::Function<const Object*(void)>::Wrap<&Test::F15>, lua::STATIC_FUNCTION }
+        { "F15", lua::Function<const Object*(void)>::Wrap<&Test::F15>, lua::STATIC_FUNCTION },
+        { "F16", lua::Function<lua::StringView(void)>::Wrap<&Test::F16>, lua::STATIC_FUNCTION },
+        { "F17", lua::Function<const char*(void)>::Wrap<&Test::F17>, lua::STATIC_FUNCTION }
 };
 
 Object *getobj (lua_State *L) {
@@ -108,7 +117,9 @@ void runtest (void)
             "check (Test.F6() == 'F6', 'return string by reference')"
             "check (Test.F7() == 'F7', 'return string by const reference')"
             "check (Test.F8() == 'F8', 'return string by rvalue reference')"
-            "check (Test.F9() == 'F9', 'return string by rvalue reference')");
+            "check (Test.F9() == 'F9', 'return string by rvalue reference')"
+            "check (Test.F16() == 'F16', 'return string view')"
+            "check (Test.F17() == 'F17', 'return c string')");
 
     runlua (L, "obj = Test.F10 ()");
     lua_getglobal (L, "obj");
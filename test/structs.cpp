@@ -0,0 +1,85 @@
+#include "common.h"
+
+struct Vec2 {
+    double x, y;
+    template<typename V>
+    static void lua_fields (V &v) {
+        v ("x", &Vec2::x);
+        v ("y", &Vec2::y);
+    }
+};
+
+struct Rect {
+    std::string name;
+    Vec2 min, max;
+    template<typename V>
+    static void lua_fields (V &v) {
+        v ("name", &Rect::name);
+        v ("min", &Rect::min);
+        v ("max", &Rect::max);
+    }
+};
+
+class Test
+{
+public:
+    static double Area (const Rect &r) {
+        return (r.max.x - r.min.x) * (r.max.y - r.min.y);
+    }
+    static Rect Grow (Rect r, double d) {
+        r.min.x -= d; r.min.y -= d;
+        r.max.x += d; r.max.y += d;
+        return r;
+    }
+    static lua::functionlist lua_functions;
+};
+
+lua::functionlist Test::lua_functions = {
+        { "Area", lua::Function<double(const Rect&)>::Wrap<&Test::Area>, lua::STATIC_FUNCTION },
+        { "Grow", lua::Function<Rect(Rect, double)>::Wrap<&Test::Grow>, lua::STATIC_FUNCTION },
+};
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+
+    lua::register_class<Test> (L, "Test");
+
+    runlua (L, "function check (value, message) assert (value, message) print (message..': passed') end");
+
+    runlua (L, "r = { name = 'r', min = { x = 1, y = 1 }, max = { x = 3, y = 4 } }"
+            "check (Test.Area (r) == 6, 'pull nested struct')");
+    runlua (L, "g = Test.Grow (r, 1)"
+            "check (g.name == 'r' and g.min.x == 0 and g.min.y == 0 and g.max.x == 4 and g.max.y == 5, 'push nested struct')");
+    dontrunlua (L, "Test.Area ({ name = 'r', min = { x = 1 }, max = { x = 3, y = 4 } })");
+    dontrunlua (L, "Test.Area (5)");
+
+    lua_getglobal (L, "r");
+    Rect r;
+    check (lua::Type<Rect>::try_pull (L, -1, r) && r.name == "r" && r.max.y == 4, "try pull struct");
+    lua_pop (L, 1);
+    lua_newtable (L);
+    check (!lua::Type<Rect>::try_pull (L, -1, r) && lua_gettop (L) == 1, "try pull invalid struct");
+    lua_pop (L, 1);
+
+    runlua (L, "records = {} for i = 1, 100 do records[i] = { id = i, x = i / 2, tag = 't'..i } end");
+    lua_getglobal (L, "records");
+    std::vector<int> ids;
+    std::vector<double> xs;
+    std::vector<std::string> tags;
+    check (lua::pull_columns (L, -1, {{ "id", "x", "tag" }}, ids, xs, tags) && lua_gettop (L) == 1
+           && ids.size () == 100 && ids[99] == 100 && xs[9] == 5 && tags[0] == "t1", "pull columns");
+    lua_pop (L, 1);
+    for (double &x : xs) x *= 2;
+    lua::push_columns (L, {{ "id", "x" }}, ids, xs);
+    lua_setglobal (L, "doubled");
+    runlua (L, "check (#doubled == 100 and doubled[10].id == 10 and doubled[10].x == 10 and doubled[10].tag == nil, 'push columns')");
+    runlua (L, "records[50].x = 'a'");
+    lua_getglobal (L, "records");
+    check (!lua::pull_columns (L, -1, {{ "id", "x" }}, ids, xs) && lua_gettop (L) == 1, "pull invalid columns");
+    // the fields of the rows before the failing one and its id are dropped again
+    check (ids.size () == 100 && xs.size () == 100 && ids[99] == 100 && xs[99] == 100,
+           "columns unchanged after a failed pull");
+    lua_pop (L, 1);
+}
@@ -0,0 +1,89 @@
+#include "common.h"
+#include <map>
+
+class Test
+{
+public:
+    static int Sum (lua::Table t) {
+        int sum = 0;
+        t.foreach<int, int> ([&] (int k, int v) { sum += v; });
+        return sum;
+    }
+    static lua::functionlist lua_functions;
+};
+
+lua::functionlist Test::lua_functions = {
+        { "Sum", lua::Function<int(lua::Table)>::Wrap<&Test::Sum>, lua::STATIC_FUNCTION },
+};
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+
+    lua::register_class<Test> (L, "Test");
+
+    runlua (L, "function check (value, message) assert (value, message) print (message..': passed') end");
+
+    runlua (L, "config = { name = 'server', port = 8080, ratio = 0.5, 10, 20, 30, [4] = 'x' }");
+
+    lua_getglobal (L, "config");
+    lua::Table config (lua::Reference (L, -1));
+    lua_pop (L, 1);
+
+    lua::Key port (L, "port");
+    check (config.get<std::string> ("name") == "server" && config.get<int> (port) == 8080
+           && config.get<int> (2) == 20, "get fields");
+    check (config.size () == 4, "table size");
+
+    std::string name;
+    int p;
+    double ratio;
+    std::tie (name, p, ratio) = config.get_many<std::string, int, double> ("name", port, std::string ("ratio"));
+    check (name == "server" && p == 8080 && ratio == 0.5, "get many fields");
+
+    bool thrown = false;
+    try {
+        config.get<int> ("name");
+    } catch (lua::Exception &e) {
+        thrown = true;
+    }
+    check (thrown && lua_gettop (L) == 0, "get field with invalid type");
+
+    config.set ("port", 9090);
+    config.set (5, std::string ("y"));
+    runlua (L, "check (config.port == 9090 and config[5] == 'y', 'set fields')");
+
+    std::map<std::string, std::string> strings;
+    config.foreach<std::string, std::string> ([&] (const std::string &k, const std::string &v) { strings[k] = v; });
+    // numbers convert to strings, without breaking the iteration
+    check (strings.size () == 8 && strings["name"] == "server" && strings["1"] == "10" && lua_gettop (L) == 0,
+           "iterate string entries");
+
+    runlua (L, "check (Test.Sum ({ 1, 2, 3, a = 4, b = 'c' }) == 6, 'stack backed table argument')");
+
+    lua::Table created = lua::Table::create (L, 0, 1);
+    created.set ("value", 1);
+    created.push ();
+    lua_setglobal (L, "created");
+    runlua (L, "check (created.value == 1, 'created table')");
+
+    // a key interned on the main state indexes a stack backed table on a coroutine
+    lua_State *T = lua_newthread (L);
+    lua_getglobal (T, "config");
+    lua::Table threadconfig (T, -1);
+    check (threadconfig.get<int> (port) == 9090 && lua_gettop (T) == 1, "key on another thread");
+    lua_pop (T, 1);
+    lua_pop (L, 1);
+
+    lua_pushinteger (L, 1);
+    lua::Table number (lua::Reference (L, -1));
+    lua_pop (L, 1);
+    thrown = false;
+    try {
+        number.get<int> ("x");
+    } catch (lua::Exception &e) {
+        thrown = std::string (e.what ()).find ("not a table") != std::string::npos;
+    }
+    check (thrown && lua_gettop (L) == 0, "registry backed value that is not a table");
+}
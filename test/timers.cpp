@@ -0,0 +1,46 @@
+#include "common.h"
+
+void runtest (void)
+{
+    lua::State L;
+    L.loadlib (luaopen_base, "");
+
+    lua::register_class (L, "timer", lua::Timers::lua_functions);
+
+    runlua (L, "log = {} function note (s) log[#log + 1] = s end");
+
+    runlua (L, "timer.after (10, function () note ('a') timer.sleep (5) note ('b') end)"
+            "timer.after (100000, function () note ('far') end)"
+            "ticks = 0 timer.every (3, function () ticks = ticks + 1 return ticks < 4 end)");
+    // many timers spread over all levels
+    runlua (L, "count = 0 for i = 1, 10000 do timer.after (i * 37, function () count = count + 1 end) end");
+
+    check (L.run_timers (9) == 3, "fire timers before they are due");
+    runlua (L, "assert (#log == 0 and ticks == 3)");
+    L.run_timers (12);
+    runlua (L, "assert (#log == 1 and log[1] == 'a' and ticks == 4)");
+    L.run_timers (15);
+    runlua (L, "assert (#log == 2 and log[2] == 'b')");
+    L.run_timers (20);
+    runlua (L, "assert (ticks == 4)");
+    L.run_timers (99999);
+    runlua (L, "assert (#log == 2)");
+    L.run_timers (100000);
+    runlua (L, "assert (#log == 3 and log[3] == 'far')");
+    L.run_timers (370000);
+    runlua (L, "assert (count == 10000)");
+    check (true, "timers fired in order");
+
+    runlua (L, "timer.after (1, function () error ('timer failed') end)");
+    bool thrown = false;
+    try {
+        L.run_timers (370001);
+    } catch (std::exception &e) {
+        thrown = std::string (e.what ()).find ("timer failed") != std::string::npos;
+    }
+    check (thrown, "errors in timers");
+    dontrunlua (L, "timer.after (1, 2)");
+
+    check (luaL_dostring (L, "timer.sleep (5)") != 0 && L.run_timers (370010) == 0, "sleep outside a coroutine");
+    lua_pop (L, 1);
+}